@@ -0,0 +1,1027 @@
+/*
+    Throughput benchmark for the json module.
+
+    make bench        default build
+    make flavours     also bench_noscan (JSON_NO_PRESCAN), bench_nosimd
+                      (JSON_NO_SIMD), bench_dfa (JSON_DFA_COMPACT) and
+                      bench_stats (JSON_STATS)
+
+    ./bench prints a readable report, ./bench suite prints the regression
+    suite below as one JSON object per line.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "json.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define cycles() __rdtsc()
+#else
+#define cycles() 0
+#endif
+
+#define CORPUS_LEN (4 << 20)
+
+static char *corpus;
+static int corpus_len;
+static uint32_t seed = 12345;
+
+static uint32_t rnd(void){
+	seed = seed * 1103515245 + 12345;
+	return(seed >> 8);
+}
+
+static double now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void gen_strings(void){
+	int i, n;
+	corpus_len = snprintf(corpus, CORPUS_LEN, "[");
+	while(corpus_len < CORPUS_LEN - 1024){
+		corpus_len += snprintf(corpus + corpus_len, CORPUS_LEN - corpus_len, "{\"level\":\"info\",\"msg\":\"");
+		n = 40 + rnd() % 200;
+		for(i = 0; i < n; i++){
+			corpus[corpus_len++] = "abcdefghij klmnopqrstuvwxyz,:{}[]"[rnd() % 33];
+		}
+		corpus_len += snprintf(corpus + corpus_len, CORPUS_LEN - corpus_len, "\\n\"},");
+	}
+	corpus[corpus_len - 1] = ']';
+}
+
+static void gen_pretty(void){
+	corpus_len = snprintf(corpus, CORPUS_LEN, "[\n");
+	while(corpus_len < CORPUS_LEN - 1024){
+		corpus_len += snprintf(corpus + corpus_len, CORPUS_LEN - corpus_len,
+			"    {\n        \"id\": %u,\n        \"name\": \"item\",\n        \"tags\": [\n            \"a\",\n            \"b\"\n        ]\n    },\n", rnd());
+	}
+	corpus_len -= 2;
+	corpus[corpus_len++] = ']';
+}
+
+static void gen_numbers(void){
+	corpus_len = snprintf(corpus, CORPUS_LEN, "[");
+	while(corpus_len < CORPUS_LEN - 64){
+		corpus_len += snprintf(corpus + corpus_len, CORPUS_LEN - corpus_len, "%u.%u,", rnd() % 100000, rnd() % 1000);
+	}
+	corpus[corpus_len - 1] = ']';
+}
+
+static void gen_ndjson(void){
+	corpus_len = 0;
+	while(corpus_len < CORPUS_LEN - 256){
+		corpus_len += snprintf(corpus + corpus_len, CORPUS_LEN - corpus_len, "{\"ts\":%u,\"level\":\"%s\",\"path\":\"/api/v1/items/%u\",\"latency\":%u.%u,\"ok\":%s}\n",
+			rnd(), (rnd() % 8) ? "info" : "error", rnd() % 100000, rnd() % 1000, rnd() % 10, (rnd() & 1) ? "true" : "false");
+	}
+}
+
+static void bench_check(const char *name){
+	json_object_t ob;
+	double t, start;
+	int runs;
+	runs = 0;
+	start = now();
+	do{
+		if(!json_check((uint8_t *)corpus, corpus_len, &ob)){
+			printf("%s: rejected\n", name);
+			return;
+		}
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_check %-8s %8.3f GB/s\n", name, (double)corpus_len * runs / t / 1e9);
+}
+
+static void bench_trusted(const char *name){
+	json_object_t ob;
+	double t, start;
+	int runs;
+	runs = 0;
+	start = now();
+	do{
+		if(!json_trusted_check((uint8_t *)corpus, corpus_len, &ob)){
+			printf("%s: rejected\n", name);
+			return;
+		}
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_trusted %-8s %6.3f GB/s\n", name, (double)corpus_len * runs / t / 1e9);
+}
+
+#define NUMBERS 4096
+
+/* the copy-and-strtod decoders json_int and json_double used to be */
+static long long int copy_strtoll(json_object_t *ob){
+	char buffer[32];
+	int l;
+	l = ob->len > 31 ? 31 : ob->len;
+	memcpy(&buffer[0], &ob->start[0], l);
+	buffer[l] = 0;
+	return(strtoll(&buffer[0], NULL, 10));
+}
+
+static double copy_strtod(json_object_t *ob){
+	char buffer[32];
+	int l;
+	l = ob->len > 31 ? 31 : ob->len;
+	memcpy(&buffer[0], &ob->start[0], l);
+	buffer[l] = 0;
+	return(strtod(&buffer[0], NULL));
+}
+
+static void bench_decode(void){
+	json_object_t ob[NUMBERS];
+	char *text;
+	double t, start, sum, d;
+	long long int v;
+	int i, runs, len;
+	text = corpus;
+	for(i = 0, len = 0; i < NUMBERS; i++){
+		ob[i].start = (uint8_t *)text + len;
+		if(i >= NUMBERS / 2){
+			ob[i].type = JSON_TYPE_DOUBLE;
+			ob[i].len = sprintf(text + len, "%.17g", (double)rnd() / (rnd() + 1));
+		}else{
+			ob[i].type = JSON_TYPE_INT;
+			ob[i].len = sprintf(text + len, "%lld", (long long int)rnd() * rnd());
+		}
+		len += ob[i].len + 1;
+	}
+#define BENCH_DECODE(name, n, expr) \
+	sum = 0; runs = 0; start = now(); \
+	do{ \
+		for(i = 0; i < n; i++){ expr; } \
+		runs++; \
+		t = now() - start; \
+	}while(t < 1.0); \
+	printf("%-16s %8.1f ns/number (%g)\n", name, t * 1e9 / runs / n, sum);
+	BENCH_DECODE("copy+strtoll", NUMBERS / 2, sum += copy_strtoll(&ob[i]));
+	BENCH_DECODE("json_to_int", NUMBERS / 2, if(json_to_int(&ob[i], &v))sum += v);
+	BENCH_DECODE("copy+strtod", NUMBERS, sum += copy_strtod(&ob[i]));
+	BENCH_DECODE("json_to_double", NUMBERS, if(json_to_double(&ob[i], &d))sum += d);
+#undef BENCH_DECODE
+}
+
+static void bench_unescape(void){
+	json_object_t ob;
+	json_utf8_t c;
+	uint8_t *out;
+	double t, start;
+	int i, n, runs, len;
+	len = 0;
+	corpus[len++] = '\"';
+	while(len < CORPUS_LEN - 16){
+		n = rnd() % 64;
+		if(n == 0){
+			len += sprintf(corpus + len, "\\n");
+		}else if(n == 1){
+			len += sprintf(corpus + len, "\\u00e9");
+		}else{
+			corpus[len++] = "abcdefghij klmnopqrstuvwxyz,:{}[]"[n % 33];
+		}
+	}
+	corpus[len++] = '\"';
+	ob.type = JSON_TYPE_STRING;
+	ob.start = (uint8_t *)corpus;
+	ob.len = len;
+	out = malloc(len);
+	runs = 0;
+	start = now();
+	do{
+		for(i = 1, n = 0; i < len - 1; i += json_decode_string(corpus + i, len - 1 - i, &c)){
+			out[n++] = c;
+		}
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_decode_string       %8.3f GB/s\n", (double)len * runs / t / 1e9);
+	runs = 0;
+	start = now();
+	do{
+		if(json_string_decode(&ob, out, len) < 0){
+			printf("json_string_decode: rejected\n");
+			break;
+		}
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_string_decode       %8.3f GB/s\n", (double)len * runs / t / 1e9);
+	free(out);
+}
+
+/* the per byte loop strtojson used to be, without its UTF-8 branches */
+static size_t bytewise_escape(char *dst, const char *src, size_t siz){
+	size_t i, d;
+	d = 0;
+	siz--;
+	for(i = 0; src[i]; i++){
+		if((src[i] == '\"') || (src[i] == '\\') || (src[i] == '\n') || (src[i] == '\r') || (src[i] == '\t')){
+			if((d + 2) >= siz)break;
+			dst[d++] = '\\';
+			dst[d++] = src[i] == '\n' ? 'n' : src[i] == '\r' ? 'r' : src[i] == '\t' ? 't' : src[i];
+		}else{
+			if((d + 1) >= siz)break;
+			dst[d++] = src[i];
+		}
+	}
+	dst[d] = 0;
+	return(d);
+}
+
+static void bench_escape(void){
+	char *out;
+	double t, start;
+	size_t n;
+	int i, runs, len;
+	for(len = 0; len < CORPUS_LEN / 2 - 1; len++){
+		i = rnd() % 64;
+		corpus[len] = i == 0 ? '\n' : i == 1 ? '\"' : "abcdefghij klmnopqrstuvwxyz,:{}[]"[i % 33];
+	}
+	corpus[len] = 0;
+	out = malloc(CORPUS_LEN * 3);
+	runs = 0;
+	start = now();
+	do{
+		bytewise_escape(out, corpus, CORPUS_LEN * 3);
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("bytewise escape          %8.3f GB/s\n", (double)len * runs / t / 1e9);
+	runs = 0;
+	start = now();
+	do{
+		n = json_escape(NULL, corpus, len);
+		json_escape(out, corpus, len);
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_escape (sized)      %8.3f GB/s (%zu bytes)\n", (double)len * runs / t / 1e9, n);
+	free(out);
+}
+
+static void bench_format(void){
+	double *d;
+	long long int *v;
+	char out[32];
+	uint64_t c;
+	double t, start;
+	int i, runs, n;
+	d = malloc(NUMBERS * sizeof(double));
+	v = malloc(NUMBERS * sizeof(long long int));
+	for(i = 0; i < NUMBERS; i++){
+		d[i] = (i & 1) ? (double)rnd() / (rnd() + 1) : (double)rnd() * 1e-3;
+		v[i] = (long long int)rnd() * rnd();
+	}
+#define BENCH_FORMAT(name, expr) \
+	n = 0; runs = 0; start = now(); c = cycles(); \
+	do{ \
+		for(i = 0; i < NUMBERS; i++){ n += expr; } \
+		runs++; \
+		t = now() - start; \
+	}while(t < 1.0); \
+	c = cycles() - c; \
+	printf("%-16s %8.1f ns/number %8.1f cycles/number (%d)\n", name, t * 1e9 / runs / NUMBERS, (double)c / runs / NUMBERS, n);
+	BENCH_FORMAT("snprintf %.17g", snprintf(out, sizeof(out), "%.17g", d[i]));
+	BENCH_FORMAT("json_dtoa", json_dtoa(d[i], out));
+	BENCH_FORMAT("snprintf %lld", snprintf(out, sizeof(out), "%lld", v[i]));
+	BENCH_FORMAT("json_itoa", json_itoa(v[i], out));
+#undef BENCH_FORMAT
+	free(d);
+	free(v);
+}
+
+static int ndjson_record(void *ctx, json_object_t *record, void *result){
+	json_object_t value;
+	(void)ctx;
+	if(!json_get_value(record->start, record->len, "level", &value))return(0);
+	*(int *)result = (int)value.len;
+	return(1);
+}
+
+static int ndjson_emit(void *ctx, json_object_t *record, void *result, int ok){
+	(void)record;
+	*(long long int *)ctx += ok ? *(int *)result : 0;
+	return(1);
+}
+
+static void bench_ndjson(void){
+	json_ndjson_t nd;
+	long long int sum;
+	double t, start;
+	int i, n, runs, threads;
+	gen_strings();
+	for(i = 0; i < corpus_len; i++){
+		if((corpus[i] == '}') && (corpus[i + 1] == ','))corpus[i + 1] = '\n';
+	}
+	corpus[0] = ' ';
+	corpus[corpus_len - 1] = '\n';
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	for(threads = 1; threads <= (n > 4 ? n : 4); threads *= 2){
+		memset(&nd, 0, sizeof(nd));
+		nd.threads = threads;
+		nd.result_size = sizeof(int);
+		nd.record = ndjson_record;
+		nd.emit = ndjson_emit;
+		nd.ctx = &sum;
+		runs = 0;
+		start = now();
+		do{
+			sum = 0;
+			json_ndjson_parse(&nd, (uint8_t *)corpus, corpus_len);
+			runs++;
+			t = now() - start;
+		}while(t < 1.0);
+		printf("ndjson %2d threads       %8.3f GB/s (%lld)\n", threads, (double)corpus_len * runs / t / 1e9, sum);
+	}
+}
+
+static void bench_parallel(void){
+	json_object_t ob;
+	double t, start;
+	int n, runs, threads;
+	gen_strings();
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	for(threads = 1; threads <= (n > 4 ? n : 4); threads *= 2){
+		runs = 0;
+		start = now();
+		do{
+			if(!json_check_parallel((uint8_t *)corpus, corpus_len, threads, &ob)){
+				printf("json_check_parallel: rejected\n");
+				return;
+			}
+			runs++;
+			t = now() - start;
+		}while(t < 1.0);
+		printf("parallel %2d threads     %8.3f GB/s (%zu)\n", threads, (double)corpus_len * runs / t / 1e9, ob.count);
+	}
+}
+
+/* read() into a heap buffer and parse, against mapping the file in place */
+static void bench_file(void){
+	char path[] = "/tmp/json_benchXXXXXX";
+	json_file_t file;
+	json_object_t ob;
+	double t, start;
+	char *buf;
+	int fd, runs, ok;
+	gen_strings();
+	fd = mkstemp(path);
+	if(fd < 0)return;
+	ok = write(fd, corpus, corpus_len) == corpus_len;
+	close(fd);
+	buf = malloc(corpus_len);
+	if(ok && (buf != NULL)){
+		runs = 0;
+		t = 1.0;
+		start = now();
+		do{
+			fd = open(path, O_RDONLY);
+			ok = read(fd, buf, corpus_len) == corpus_len;
+			close(fd);
+			if(!ok || !json_check((uint8_t *)buf, corpus_len, &ob))break;
+			runs++;
+			t = now() - start;
+		}while(t < 1.0);
+		printf("read+json_check      %8.3f GB/s\n", (double)corpus_len * runs / t / 1e9);
+		runs = 0;
+		t = 1.0;
+		start = now();
+		do{
+			if(!json_file_open(&file, path))break;
+			ok = json_check(file.ptr, file.len, &ob);
+			json_file_close(&file);
+			if(!ok)break;
+			runs++;
+			t = now() - start;
+		}while(t < 1.0);
+		printf("mmap+json_check      %8.3f GB/s\n", (double)corpus_len * runs / t / 1e9);
+	}
+	free(buf);
+	unlink(path);
+}
+
+/* every member of one message through json_get_value, against one DOM build */
+static void bench_dom(void){
+	char msg[4096], key[40][16];
+	json_object_t ob;
+	json_arena_t arena;
+	json_dom_t *dom;
+	double t, start;
+	int i, len, runs, found;
+	len = sprintf(msg, "{");
+	for(i = 0; i < 40; i++){
+		sprintf(key[i], "field%02d", (i * 7) % 40);
+		len += sprintf(&msg[len], "%s\"field%02d\":%s", i ? "," : "", i, (i & 1) ? "\"some text value\"" : "[1,2,3]");
+	}
+	len += sprintf(&msg[len], "}");
+	runs = 0;
+	start = now();
+	do{
+		for(i = 0, found = 0; i < 40; i++)found += json_get_value((uint8_t *)msg, len, key[i], &ob);
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_get_value x40   %8.1f us/msg (%d)\n", t / runs * 1e6, found);
+	json_arena_init(&arena, NULL, 0);
+	runs = 0;
+	start = now();
+	do{
+		dom = json_dom_parse((uint8_t *)msg, len, &arena);
+		for(i = 0, found = 0; (dom != NULL) && (i < 40); i++)found += json_dom_get_value(dom, key[i]) != NULL;
+		json_arena_free(&arena);
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_dom_parse+x40   %8.1f us/msg (%d)\n", t / runs * 1e6, found);
+}
+
+/* 20 fields of a 4 KB message by name list and by precompiled key set */
+static void bench_keyset(void){
+	char msg[8192], name[20][16], *keys[20];
+	json_object_t values[20];
+	json_keyset_t ks;
+	double t, start;
+	int i, len, runs, found;
+	for(i = 0; i < 20; i++){
+		sprintf(name[i], "attribute_%02d", i * 3);
+		keys[i] = name[i];
+	}
+	len = sprintf(msg, "{");
+	for(i = 0; i < 60; i++){
+		len += sprintf(&msg[len], "%s\"attribute_%02d\":\"value %04d of a longer text\"", i ? "," : "", 59 - i, i);
+	}
+	len += sprintf(&msg[len], "}");
+	runs = 0;
+	start = now();
+	do{
+		found = json_get_values((uint8_t *)msg, len, keys, 20, values);
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_get_values x20  %8.1f us/msg (%d)\n", t / runs * 1e6, found);
+	if(!json_keyset_init(&ks, keys, 20))return;
+	runs = 0;
+	start = now();
+	do{
+		found = json_get_keyset((uint8_t *)msg, len, &ks, values);
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_get_keyset x20  %8.1f us/msg (%d)\n", t / runs * 1e6, found);
+	json_keyset_free(&ks);
+}
+
+/*
+    Regression suite, run with "bench suite". Each corpus is a list of
+    documents and every operation is timed per document, so the output
+    gives latency percentiles next to throughput. One JSON object per line
+    is printed for every operation and corpus, with the build flags, for
+    diffing runs across versions.
+*/
+
+#define SUITE_TIME    0.5
+#define SUITE_SAMPLES (1 << 20)
+#define SUITE_ITER    64
+
+struct suite_corpus{
+	const char *name;
+	const char *key;	/* member looked up by json_get_value, NULL for arrays */
+	char *buf;
+	size_t len;
+	size_t size;
+	size_t *doc;	/* doc[d] .. doc[d + 1] */
+	int docs;
+	int max;
+	json_object_t *num;	/* numbers of document d are num[nfirst[d] .. nfirst[d + 1]] */
+	size_t *nfirst;
+	size_t nums;
+	char **str;	/* NUL terminated copies of the string values, likewise */
+	size_t *sfirst;
+	size_t strs;
+	char *out;
+};
+
+static volatile long long int sink;
+
+static void suite_printf(struct suite_corpus *c, const char *fmt, ...){
+	va_list ap;
+	int n;
+	for(;;){
+		va_start(ap, fmt);
+		n = vsnprintf(c->buf + c->len, c->size - c->len, fmt, ap);
+		va_end(ap);
+		if((size_t)n < c->size - c->len)break;
+		c->size = 2 * c->size + n;
+		c->buf = realloc(c->buf, c->size);
+	}
+	c->len += n;
+}
+
+static void suite_end_doc(struct suite_corpus *c){
+	if(c->docs + 2 > c->max){
+		c->max = 2 * c->max + 16;
+		c->doc = realloc(c->doc, c->max * sizeof(size_t));
+	}
+	c->doc[++c->docs] = c->len;
+}
+
+static void suite_text(struct suite_corpus *c, int n){
+	int i, r;
+	for(i = 0; i < n; i++){
+		r = rnd() % 64;
+		if(r == 0){
+			suite_printf(c, "\\n");
+		}else if(r == 1){
+			suite_printf(c, "\\\"");
+		}else if(r == 2){
+			suite_printf(c, "\\u00e9");
+		}else{
+			suite_printf(c, "%c", "abcdefghij klmnopqrstuvwxyz,:{}[]"[r % 33]);
+		}
+	}
+}
+
+static void suite_api(struct suite_corpus *c){
+	int d;
+	for(d = 0; d < 4000; d++){
+		suite_printf(c, "{\"id\":%u,\"method\":\"user.update\",\"ok\":%s,\"ts\":%u.%03u,", rnd(), (rnd() & 1) ? "true" : "false", 1600000000 + rnd() % 100000000, rnd() % 1000);
+		suite_printf(c, "\"user\":{\"name\":\"user%u\",\"email\":\"user%u@example.com\",\"roles\":[\"admin\",\"dev\"],\"quota\":%u.%u},", rnd() % 10000, rnd() % 10000, rnd() % 1000, rnd() % 100);
+		suite_printf(c, "\"params\":{\"limit\":%u,\"offset\":%u,\"query\":\"", rnd() % 100, rnd() % 100000);
+		suite_text(c, 20 + rnd() % 60);
+		suite_printf(c, "\"}}");
+		suite_end_doc(c);
+	}
+}
+
+static void suite_numbers(struct suite_corpus *c){
+	int d, i;
+	for(d = 0; d < 8; d++){
+		suite_printf(c, "[");
+		for(i = 0; i < 65536; i++){
+			if(i & 1){
+				suite_printf(c, "%s%u.%u", i ? "," : "", rnd() % 100000, rnd() % 1000);
+			}else{
+				suite_printf(c, "%s%d", i ? "," : "", (int)(rnd() % 2000000) - 1000000);
+			}
+		}
+		suite_printf(c, "]");
+		suite_end_doc(c);
+	}
+}
+
+static void suite_logs(struct suite_corpus *c){
+	int d, i;
+	for(d = 0; d < 8; d++){
+		suite_printf(c, "[");
+		for(i = 0; i < 2500; i++){
+			suite_printf(c, "%s{\"level\":\"%s\",\"msg\":\"", i ? "," : "", (rnd() % 8) ? "info" : "error");
+			suite_text(c, 40 + rnd() % 200);
+			suite_printf(c, "\"}");
+		}
+		suite_printf(c, "]");
+		suite_end_doc(c);
+	}
+}
+
+static void suite_config_node(struct suite_corpus *c, int depth){
+	suite_printf(c, "{\n%*s\"name\": \"node%u\",\n%*s\"enabled\": %s,\n%*s\"timeout\": %u.5,\n%*s\"tags\": [\"a\", \"b\", \"c\"],\n%*s\"child\": ",
+		depth, "", rnd() % 1000, depth, "", (rnd() & 1) ? "true" : "false", depth, "", rnd() % 60, depth, "", depth, "");
+	if(depth < 32){
+		suite_config_node(c, depth + 1);
+	}else{
+		suite_printf(c, "null");
+	}
+	suite_printf(c, "\n%*s}", depth, "");
+}
+
+static void suite_config(struct suite_corpus *c){
+	int d;
+	for(d = 0; d < 500; d++){
+		suite_config_node(c, 0);
+		suite_end_doc(c);
+	}
+}
+
+static void suite_ndjson(struct suite_corpus *c){
+	int d;
+	for(d = 0; d < 20000; d++){
+		suite_printf(c, "{\"ts\":%u,\"level\":\"%s\",\"latency\":%u,\"path\":\"/api/v1/items/%u\",\"msg\":\"", rnd(), (rnd() % 8) ? "info" : "error", rnd() % 1000, rnd() % 100000);
+		suite_text(c, 20 + rnd() % 100);
+		suite_printf(c, "\"}\n");
+		suite_end_doc(c);
+	}
+}
+
+static int suite_number(void *ctx, json_object_t *value){
+	struct suite_corpus *c;
+	c = ctx;
+	/* doubles the array whenever the count reaches a power of two */
+	if((c->nums & (c->nums - 1)) == 0)c->num = realloc(c->num, (c->nums ? 2 * c->nums : 1) * sizeof(json_object_t));
+	c->num[c->nums++] = *value;
+	return(1);
+}
+
+static int suite_string(void *ctx, json_object_t *value){
+	struct suite_corpus *c;
+	char *s;
+	c = ctx;
+	s = malloc(value->len - 1);
+	memcpy(s, value->start + 1, value->len - 2);
+	s[value->len - 2] = 0;
+	if((c->strs & (c->strs - 1)) == 0)c->str = realloc(c->str, (c->strs ? 2 * c->strs : 1) * sizeof(char *));
+	c->str[c->strs++] = s;
+	return(1);
+}
+
+/* gathers the numbers and strings of every document for the decode and escape rows */
+static void suite_tokens(struct suite_corpus *c){
+	json_sax_t sax;
+	int d;
+	memset(&sax, 0, sizeof(sax));
+	sax.integer = suite_number;
+	sax.real = suite_number;
+	sax.string = suite_string;
+	c->nfirst = malloc((c->docs + 1) * sizeof(size_t));
+	c->sfirst = malloc((c->docs + 1) * sizeof(size_t));
+	for(d = 0; d < c->docs; d++){
+		c->nfirst[d] = c->nums;
+		c->sfirst[d] = c->strs;
+		json_sax_parse((uint8_t *)c->buf + c->doc[d], c->doc[d + 1] - c->doc[d], &sax, c);
+	}
+	c->nfirst[d] = c->nums;
+	c->sfirst[d] = c->strs;
+	c->out = malloc(6 * c->len + 1);
+}
+
+static size_t op_check(struct suite_corpus *c, int d){
+	json_object_t ob;
+	size_t len;
+	len = c->doc[d + 1] - c->doc[d];
+	if(!json_check((uint8_t *)c->buf + c->doc[d], len, &ob))return(0);
+	sink += ob.count;
+	return(len);
+}
+
+static size_t op_get_value(struct suite_corpus *c, int d){
+	json_object_t ob;
+	size_t len;
+	len = c->doc[d + 1] - c->doc[d];
+	if((c->key == NULL) || !json_get_value((uint8_t *)c->buf + c->doc[d], len, (char *)c->key, &ob))return(0);
+	sink += ob.len;
+	return(len);
+}
+
+/* json_get over the first SUITE_ITER members, bytes are those up to the last one */
+static size_t op_get_iter(struct suite_corpus *c, int d){
+	json_object_t key, value;
+	uint8_t *ptr;
+	size_t len, i, end;
+	ptr = (uint8_t *)c->buf + c->doc[d];
+	len = c->doc[d + 1] - c->doc[d];
+	for(i = 0, end = 0; (i < SUITE_ITER) && json_get(ptr, len, i, &key, &value); i++){
+		end = value.start + value.len - ptr;
+	}
+	sink += i;
+	return(end);
+}
+
+static size_t op_number(struct suite_corpus *c, int d){
+	size_t i, bytes;
+	long long int v;
+	double f;
+	for(i = c->nfirst[d], bytes = 0, v = 0, f = 0; i < c->nfirst[d + 1]; i++){
+		if(c->num[i].type == JSON_TYPE_INT){
+			v += json_int(&c->num[i]);
+		}else{
+			f += json_double(&c->num[i]);
+		}
+		bytes += c->num[i].len;
+	}
+	sink += v + (long long int)f;
+	return(bytes);
+}
+
+static size_t op_escape(struct suite_corpus *c, int d){
+	size_t i, bytes, n;
+	for(i = c->sfirst[d], bytes = 0; i < c->sfirst[d + 1]; i++){
+		n = strlen(c->str[i]);
+		sink += strtojson(c->out, c->str[i], 6 * n + 1);
+		bytes += n;
+	}
+	return(bytes);
+}
+
+static int cmp_double(const void *a, const void *b){
+	double x, y;
+	x = *(const double *)a;
+	y = *(const double *)b;
+	return((x > y) - (x < y));
+}
+
+static const char *suite_build(void){
+#if defined(JSON_STATS)
+	return("stats");
+#elif defined(JSON_DFA_COMPACT)
+	return("dfa");
+#elif defined(JSON_NO_PRESCAN)
+	return("noprescan");
+#elif defined(JSON_NO_SIMD)
+	return("nosimd");
+#else
+	return("default");
+#endif
+}
+
+static void suite_run(const char *op, struct suite_corpus *c, size_t (*fn)(struct suite_corpus *, int), double *sample){
+	json_writer_t w;
+	char line[512];
+	double t, t0, busy, start;
+	size_t n, bytes, b;
+	int d;
+	n = 0;
+	bytes = 0;
+	busy = 0;
+	start = now();
+	do{
+		for(d = 0; d < c->docs; d++){
+			t0 = now();
+			b = fn(c, d);
+			t = now() - t0;
+			if(b == 0)continue;
+			if(n < SUITE_SAMPLES)sample[n] = t;
+			n++;
+			bytes += b;
+			busy += t;
+		}
+	}while((n > 0) && (now() - start < SUITE_TIME));
+	if(n == 0)return;
+	if(n > SUITE_SAMPLES)n = SUITE_SAMPLES;
+	qsort(sample, n, sizeof(double), cmp_double);
+	json_writer_init(&w, line, sizeof(line), -1);
+	json_write_begin_object(&w);
+	json_write_key(&w, "build", 5);
+	json_write_string(&w, suite_build(), strlen(suite_build()));
+	json_write_key(&w, "op", 2);
+	json_write_string(&w, op, strlen(op));
+	json_write_key(&w, "corpus", 6);
+	json_write_string(&w, c->name, strlen(c->name));
+	json_write_key(&w, "samples", 7);
+	json_write_int(&w, n);
+	json_write_key(&w, "mb_s", 4);
+	json_write_double(&w, (double)(long long int)(bytes / busy / 1e4) / 100);
+	json_write_key(&w, "p50_us", 6);
+	json_write_double(&w, (double)(long long int)(sample[n / 2] * 1e8) / 100);
+	json_write_key(&w, "p90_us", 6);
+	json_write_double(&w, (double)(long long int)(sample[n * 9 / 10] * 1e8) / 100);
+	json_write_key(&w, "p99_us", 6);
+	json_write_double(&w, (double)(long long int)(sample[n * 99 / 100] * 1e8) / 100);
+	json_write_key(&w, "max_us", 6);
+	json_write_double(&w, (double)(long long int)(sample[n - 1] * 1e8) / 100);
+	json_write_end_object(&w);
+	if(!w.error)printf("%.*s\n", (int)w.len, w.buf);
+	fflush(stdout);
+}
+
+static void suite(void){
+	static struct{
+		const char *name;
+		const char *key;
+		void (*gen)(struct suite_corpus *);
+	}corpora[] = {
+		{"api", "params", suite_api},
+		{"numbers", NULL, suite_numbers},
+		{"logs", NULL, suite_logs},
+		{"config", "child", suite_config},
+		{"ndjson", "msg", suite_ndjson},
+	};
+	struct suite_corpus c;
+	double *sample;
+	size_t i, k;
+	sample = malloc(SUITE_SAMPLES * sizeof(double));
+	for(k = 0; k < sizeof(corpora) / sizeof(corpora[0]); k++){
+		memset(&c, 0, sizeof(c));
+		c.name = corpora[k].name;
+		c.key = corpora[k].key;
+		c.size = 1 << 20;
+		c.buf = malloc(c.size);
+		c.max = 16;
+		c.doc = malloc(c.max * sizeof(size_t));
+		c.doc[0] = 0;
+		corpora[k].gen(&c);
+		suite_tokens(&c);
+		suite_run("json_check", &c, op_check, sample);
+		suite_run("json_get_value", &c, op_get_value, sample);
+		suite_run("json_get_iter", &c, op_get_iter, sample);
+		suite_run("json_int_double", &c, op_number, sample);
+		suite_run("strtojson", &c, op_escape, sample);
+		for(i = 0; i < c.strs; i++)free(c.str[i]);
+		free(c.str);
+		free(c.num);
+		free(c.nfirst);
+		free(c.sfirst);
+		free(c.doc);
+		free(c.buf);
+		free(c.out);
+	}
+	free(sample);
+}
+
+/* four typed fields per NDJSON record, per record lookups against the columnar extractor */
+static void bench_columns(void){
+	json_column_t column[4];
+	json_columns_t cols;
+	json_object_t ob;
+	int64_t *ts;
+	double *latency, sum;
+	json_object_t *level;
+	uint8_t *ok, *valid[4];
+	double t, start;
+	char *p, *end, *nl;
+	size_t rows, used, off;
+	int runs, i;
+	gen_ndjson();
+	for(p = corpus, rows = 0; (p = memchr(p, '\n', corpus + corpus_len - p)) != NULL; p++)rows++;
+	ts = malloc(rows * sizeof(int64_t));
+	latency = malloc(rows * sizeof(double));
+	level = malloc(rows * sizeof(json_object_t));
+	ok = malloc(rows);
+	for(i = 0; i < 4; i++)valid[i] = malloc(rows / 8 + 1);
+	runs = 0;
+	start = now();
+	do{
+		sum = 0;
+		for(p = corpus, end = corpus + corpus_len, rows = 0; p < end; p = nl + 1, rows++){
+			nl = memchr(p, '\n', end - p);
+			if(json_get_value((uint8_t *)p, nl - p, "ts", &ob))ts[rows] = json_int(&ob);
+			if(json_get_value((uint8_t *)p, nl - p, "latency", &ob))latency[rows] = json_double(&ob);
+			if(json_get_value((uint8_t *)p, nl - p, "level", &ob))level[rows] = ob;
+			if(json_get_value((uint8_t *)p, nl - p, "ok", &ob))ok[rows] = ob.type == JSON_TYPE_TRUE;
+			sum += latency[rows];
+		}
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_get_value rows  %8.3f GB/s (%g)\n", (double)corpus_len * runs / t / 1e9, sum);
+	column[0].name = "ts";
+	column[0].type = JSON_COLUMN_INT;
+	column[0].data = ts;
+	column[1].name = "latency";
+	column[1].type = JSON_COLUMN_DOUBLE;
+	column[1].data = latency;
+	column[2].name = "level";
+	column[2].type = JSON_COLUMN_STRING;
+	column[2].data = level;
+	column[3].name = "ok";
+	column[3].type = JSON_COLUMN_BOOL;
+	column[3].data = ok;
+	for(i = 0; i < 4; i++)column[i].valid = valid[i];
+	if(json_columns_init(&cols, column, 4, rows)){
+		runs = 0;
+		start = now();
+		do{
+			for(off = 0, cols.rows = 0; off < (size_t)corpus_len; off += used){
+				json_columns_ndjson(&cols, (uint8_t *)corpus + off, corpus_len - off, &used);
+				if(used == 0)break;
+			}
+			for(rows = 0, sum = 0; rows < cols.rows; rows++)sum += latency[rows];
+			runs++;
+			t = now() - start;
+		}while(t < 1.0);
+		printf("json_columns_ndjson  %8.3f GB/s (%g)\n", (double)corpus_len * runs / t / 1e9, sum);
+		json_columns_free(&cols);
+	}
+	free(ts);
+	free(latency);
+	free(level);
+	free(ok);
+	for(i = 0; i < 4; i++)free(valid[i]);
+}
+
+/* error records over a latency, per line lookups against a compiled query */
+static void bench_query(void){
+	char *fields[] = {"@.ts", "@.path"};
+	json_writer_t w;
+	json_query_t *q;
+	json_object_t ob;
+	double t, start;
+	char *p, *end, *nl;
+	ssize_t matches;
+	int runs;
+	gen_ndjson();
+	runs = 0;
+	start = now();
+	do{
+		json_writer_init(&w, NULL, 0, -1);
+		for(p = corpus, end = corpus + corpus_len, matches = 0; p < end; p = nl + 1){
+			nl = memchr(p, '\n', end - p);
+			if(!json_value_isequal((uint8_t *)p, nl - p, "level", "error"))continue;
+			if(!json_get_value((uint8_t *)p, nl - p, "latency", &ob) || (json_double(&ob) <= 500))continue;
+			json_write_begin_array(&w);
+			if(json_get_value((uint8_t *)p, nl - p, "ts", &ob))json_write_value(&w, &ob);
+			if(json_get_value((uint8_t *)p, nl - p, "path", &ob))json_write_value(&w, &ob);
+			json_write_end_array(&w);
+			matches++;
+		}
+		json_writer_free(&w);
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_get_value filter %7.3f GB/s (%zd)\n", (double)corpus_len * runs / t / 1e9, matches);
+	q = json_query_compile("@.level == \"error\" && @.latency > 500", fields, 2);
+	if(q != NULL){
+		runs = 0;
+		start = now();
+		do{
+			json_writer_init(&w, NULL, 0, -1);
+			matches = json_query_ndjson(q, (uint8_t *)corpus, corpus_len, &w);
+			json_writer_free(&w);
+			runs++;
+			t = now() - start;
+		}while(t < 1.0);
+		printf("json_query_ndjson    %7.3f GB/s (%zd)\n", (double)corpus_len * runs / t / 1e9, matches);
+		json_query_free(q);
+	}
+}
+
+/* sensor style array of doubles, per element json_get against one bulk decode */
+static void bench_array(void){
+	static double out[2000];
+	json_object_t array, key, ob;
+	double t, start, sum;
+	size_t count;
+	int runs, i, n;
+	n = 2000;
+	corpus_len = snprintf(corpus, CORPUS_LEN, "[");
+	for(i = 0; i < n; i++){
+		corpus_len += snprintf(corpus + corpus_len, CORPUS_LEN - corpus_len, "%s%u.%02u", i ? "," : "", rnd() % 1000, rnd() % 100);
+	}
+	corpus_len += snprintf(corpus + corpus_len, CORPUS_LEN - corpus_len, "]");
+	if(!json_check((uint8_t *)corpus, corpus_len, &array))return;
+	runs = 0;
+	start = now();
+	do{
+		for(i = 0, sum = 0; i < n; i++){
+			if(json_get((uint8_t *)corpus, corpus_len, i, &key, &ob))sum += json_double(&ob);
+		}
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_get+json_double %10.1f us/array (%g)\n", t / runs * 1e6, sum);
+	runs = 0;
+	start = now();
+	do{
+		json_array_to_double(&array, out, n, &count);
+		for(i = 0, sum = 0; i < (int)count; i++)sum += out[i];
+		runs++;
+		t = now() - start;
+	}while(t < 1.0);
+	printf("json_array_to_double %10.1f us/array (%g)\n", t / runs * 1e6, sum);
+}
+
+int main(int argc, char **argv){
+	json_stats_t stats;
+	if((argc > 1) && !strcmp(argv[1], "suite")){
+		suite();
+		return(0);
+	}
+	corpus = malloc(CORPUS_LEN);
+	gen_strings();
+	bench_check("strings");
+	bench_trusted("strings");
+	gen_pretty();
+	bench_check("pretty");
+	bench_trusted("pretty");
+	gen_numbers();
+	bench_check("numbers");
+	bench_trusted("numbers");
+	bench_decode();
+	bench_unescape();
+	bench_escape();
+	bench_format();
+	bench_ndjson();
+	bench_parallel();
+	bench_file();
+	bench_dom();
+	bench_keyset();
+	bench_columns();
+	bench_query();
+	bench_array();
+	if(json_stats_snapshot(&stats, 1)){
+		printf("stats: %llu bytes, %llu rescans, depth %llu, %llu number and %llu string decodes\n",
+			(unsigned long long)stats.bytes, (unsigned long long)stats.rescans, (unsigned long long)stats.max_depth,
+			(unsigned long long)stats.number_decodes, (unsigned long long)stats.string_decodes);
+		printf("stats: Mcycles check %llu lookup %llu number %llu string %llu\n",
+			(unsigned long long)(stats.cycles[JSON_PHASE_CHECK] / 1000000), (unsigned long long)(stats.cycles[JSON_PHASE_LOOKUP] / 1000000),
+			(unsigned long long)(stats.cycles[JSON_PHASE_NUMBER] / 1000000), (unsigned long long)(stats.cycles[JSON_PHASE_STRING] / 1000000));
+	}
+	free(corpus);
+	return(0);
+}
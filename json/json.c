@@ -2,37 +2,285 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <float.h>
+#include <math.h>
+#include <locale.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "json.h"
 
+#if !defined(JSON_NO_SIMD) && (defined(__x86_64__) || defined(__i386__))
+#define JSON_SIMD_X86
+#include <immintrin.h>
+#endif
+
 #ifdef MAIN_CONTROLLER 
 #import <Foundation/Foundation.h>
 #import "NSUtil.h"
 #endif
 
-#define JSON_STACK_LEN 32
+#define JSON_STACK_LEN 256	/* levels kept inline, deeper ones spill to the heap */
 
 #define true  1
 #define false 0
 #define ___   -1     /* the universal error code */
 
+/*
+    Instrumentation, compiled in with -DJSON_STATS. Every thread counts into
+    its own block, registered on first use and folded into a retired total
+    when the thread exits, so the hot paths never share a cache line. A
+    phase is timed from entry to every return of its function; nested
+    phases are charged to the outermost one only. Counters are written with
+    relaxed atomics by their owner alone, so a snapshot from another thread
+    is a consistent sum of each counter but not across counters. Without
+    JSON_STATS the macros are empty and the snapshot reports zeros.
+*/
+#ifdef JSON_STATS
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define JSON_cycles() __rdtsc()
+#else
+#include <time.h>
+static inline uint64_t JSON_cycles(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+#endif
+
+#define JSON_STATS_WORDS (sizeof(json_stats_t) / sizeof(uint64_t))
+#define JSON_STATS_MAX   (offsetof(json_stats_t, max_depth) / sizeof(uint64_t))
+
+struct JSON_stats_block{
+	json_stats_t s;
+	struct JSON_stats_block *next;
+};
+
+struct JSON_phase{
+	int phase;
+	uint64_t start;
+};
+
+static pthread_mutex_t JSON_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t JSON_stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t JSON_stats_key;
+static struct JSON_stats_block *JSON_stats_list;
+static json_stats_t JSON_stats_retired;
+static struct JSON_stats_block JSON_stats_lost;	/* shared by threads whose block could not be allocated */
+static __thread struct JSON_stats_block *JSON_stats_mine;
+static __thread int JSON_stats_depth;	/* phases open on this thread */
+
+static void JSON_stats_fold(json_stats_t *dst, json_stats_t *src){
+	uint64_t *d, *s, v;
+	size_t i;
+	d = (uint64_t *)dst;
+	s = (uint64_t *)src;
+	for(i = 0; i < JSON_STATS_WORDS; i++){
+		v = __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+		if(i != JSON_STATS_MAX){
+			d[i] += v;
+		}else if(v > d[i]){
+			d[i] = v;
+		}
+	}
+}
+
+static void JSON_stats_zero(json_stats_t *stats){
+	uint64_t *s;
+	size_t i;
+	s = (uint64_t *)stats;
+	for(i = 0; i < JSON_STATS_WORDS; i++)__atomic_store_n(&s[i], 0, __ATOMIC_RELAXED);
+}
+
+static void JSON_stats_exit(void *p){
+	struct JSON_stats_block *b, **l;
+	b = p;
+	pthread_mutex_lock(&JSON_stats_lock);
+	JSON_stats_fold(&JSON_stats_retired, &b->s);
+	for(l = &JSON_stats_list; *l != NULL; l = &(*l)->next){
+		if(*l == b){
+			*l = b->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&JSON_stats_lock);
+	free(b);
+}
+
+static void JSON_stats_key_init(void){
+	pthread_key_create(&JSON_stats_key, JSON_stats_exit);
+}
+
+static struct JSON_stats_block *JSON_stats_self(void){
+	struct JSON_stats_block *b;
+	if(JSON_stats_mine != NULL)return(JSON_stats_mine);
+	pthread_once(&JSON_stats_once, JSON_stats_key_init);
+	b = calloc(1, sizeof(struct JSON_stats_block));
+	if((b == NULL) || pthread_setspecific(JSON_stats_key, b)){
+		free(b);
+		JSON_stats_mine = &JSON_stats_lost;
+		return(JSON_stats_mine);
+	}
+	pthread_mutex_lock(&JSON_stats_lock);
+	b->next = JSON_stats_list;
+	JSON_stats_list = b;
+	pthread_mutex_unlock(&JSON_stats_lock);
+	JSON_stats_mine = b;
+	return(b);
+}
+
+/*
+    A block has a single writer, so a load and a store are enough, except
+    for the shared fallback block, which needs real read-modify-writes.
+*/
+static inline void JSON_stats_add(struct JSON_stats_block *b, size_t off, uint64_t n){
+	uint64_t *c;
+	c = (uint64_t *)((uint8_t *)&b->s + off);
+	if(b == &JSON_stats_lost){
+		__atomic_fetch_add(c, n, __ATOMIC_RELAXED);
+	}else{
+		__atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+	}
+}
+
+static inline void JSON_stats_max(struct JSON_stats_block *b, size_t off, uint64_t v){
+	uint64_t *c, old;
+	c = (uint64_t *)((uint8_t *)&b->s + off);
+	old = __atomic_load_n(c, __ATOMIC_RELAXED);
+	if(b == &JSON_stats_lost){
+		while((v > old) && !__atomic_compare_exchange_n(c, &old, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	}else if(v > old){
+		__atomic_store_n(c, v, __ATOMIC_RELAXED);
+	}
+}
+
+static inline struct JSON_phase JSON_phase_begin(int phase){
+	struct JSON_phase p;
+	p.phase = (JSON_stats_depth++ == 0) ? phase : -1;
+	p.start = JSON_cycles();
+	return(p);
+}
+
+static void JSON_phase_end(struct JSON_phase *p){
+	struct JSON_stats_block *b;
+	JSON_stats_depth--;
+	if(p->phase < 0)return;
+	b = JSON_stats_self();
+	JSON_stats_add(b, offsetof(json_stats_t, cycles) + p->phase * sizeof(uint64_t), JSON_cycles() - p->start);
+	JSON_stats_add(b, offsetof(json_stats_t, calls) + p->phase * sizeof(uint64_t), 1);
+}
+
+#define JSON_STAT_ADD(field, n) JSON_stats_add(JSON_stats_self(), offsetof(json_stats_t, field), (n))
+#define JSON_STAT_MAX(field, v) JSON_stats_max(JSON_stats_self(), offsetof(json_stats_t, field), (v))
+#define JSON_STATS_PHASE(phase) struct JSON_phase JSON_phase __attribute__((cleanup(JSON_phase_end))) = JSON_phase_begin(phase)
+
+#else
+
+#define JSON_STAT_ADD(field, n)
+#define JSON_STAT_MAX(field, v)
+#define JSON_STATS_PHASE(phase)
+
+#endif
+
+int json_stats_snapshot(json_stats_t *stats, int all){
+/*
+    With all 0 the counters of the calling thread, otherwise the sum over
+    every thread including those that have exited. Returns 0 if the
+    library was built without JSON_STATS.
+*/
+#ifdef JSON_STATS
+	struct JSON_stats_block *b;
+	memset(stats, 0, sizeof(json_stats_t));
+	if(!all){
+		JSON_stats_fold(stats, &JSON_stats_self()->s);
+		return(1);
+	}
+	pthread_mutex_lock(&JSON_stats_lock);
+	JSON_stats_fold(stats, &JSON_stats_retired);
+	for(b = JSON_stats_list; b != NULL; b = b->next)JSON_stats_fold(stats, &b->s);
+	JSON_stats_fold(stats, &JSON_stats_lost.s);
+	pthread_mutex_unlock(&JSON_stats_lock);
+	return(1);
+#else
+	(void)all;
+	memset(stats, 0, sizeof(json_stats_t));
+	return(0);
+#endif
+}
+
+void json_stats_reset(int all){
+/*
+    Counters of other threads are cleared with plain stores, an update they
+    make at the same moment may survive the reset.
+*/
+#ifdef JSON_STATS
+	struct JSON_stats_block *b;
+	if(!all){
+		JSON_stats_zero(&JSON_stats_self()->s);
+		return;
+	}
+	pthread_mutex_lock(&JSON_stats_lock);
+	JSON_stats_zero(&JSON_stats_retired);
+	for(b = JSON_stats_list; b != NULL; b = b->next)JSON_stats_zero(&b->s);
+	JSON_stats_zero(&JSON_stats_lost.s);
+	pthread_mutex_unlock(&JSON_stats_lock);
+#else
+	(void)all;
+#endif
+}
+
+/*
+    The mode stack. A mode takes two bits, so the first JSON_STACK_LEN
+    levels fit in 64 bytes inside the parser; deeper levels go to a spill
+    buffer that grows on demand and is freed with the parser.
+*/
+struct JSON_stack{
+	uint64_t level[JSON_STACK_LEN / 32];
+	uint64_t *spill;
+	size_t size;
+};
+
 struct JSON_struct{
 	int state;
-	int top;
-	int stack[JSON_STACK_LEN];
+	ssize_t top;
+	struct JSON_stack stack;
 	uint8_t *start;
 	uint8_t *key_start;
-	int key_len;
+	size_t key_len;
 	uint8_t *value_start;
-	int value_len;
-	int value_count;
+	size_t value_len;
+	size_t value_count;
 	int value_type;
-	int len;
+	size_t len;
 	int type;
-	int count;
+	size_t count;
+	int stop;
+	int (*event)(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len);
+	void *ctx;
 };
 
+/*
+    Events reported by JSON_scanner_char. The depth of an event is jc->top at
+    the time of the call, so the top level value has depth 0.
+*/
+#define JSON_EVENT_BEGIN 1
+#define JSON_EVENT_END   2
+#define JSON_EVENT_KEY   3
+#define JSON_EVENT_VALUE 4
+
+#define JSON_IS_NUMBER(state) (((state) == ZE) || ((state) == IN) || ((state) == FR) || ((state) == E3))
+
 static json_utf8_t hex_to_utf8(uint8_t c);
 static int JSON_checker_char(struct JSON_struct *jc, uint8_t *next_char);
+static void JSON_scanner_init(struct JSON_struct *jc, int (*event)(struct JSON_struct *, int, int, uint8_t *, size_t), void *ctx);
+static int JSON_scanner_char(struct JSON_struct *jc, uint8_t *next_char);
+static int JSON_scanner_end(struct JSON_struct *jc, uint8_t *end);
+static ssize_t JSON_scan(struct JSON_struct *jc, uint8_t *ptr, size_t len);
 
 /*
     Characters are mapped into these 31 character classes. This allows for
@@ -193,16 +441,54 @@ enum modes {
     MODE_OBJECT,
 };
 
+static void JSON_stack_init(struct JSON_stack *s){
+	memset(s->level, 0, sizeof(s->level));
+	s->spill = NULL;
+	s->size = 0;
+}
+
+static void JSON_stack_free(struct JSON_stack *s){
+	free(s->spill);
+	s->spill = NULL;
+	s->size = 0;
+}
+
+static inline int JSON_stack_get(struct JSON_stack *s, size_t i){
+	if(i < JSON_STACK_LEN)return((s->level[i >> 5] >> ((i & 31) * 2)) & 3);
+	i -= JSON_STACK_LEN;
+	return((s->spill[i >> 5] >> ((i & 31) * 2)) & 3);
+}
+
+static inline int JSON_stack_set(struct JSON_stack *s, size_t i, int mode){
+	uint64_t *w, *spill;
+	size_t size;
+	if(i < JSON_STACK_LEN){
+		w = &s->level[i >> 5];
+	}else{
+		i -= JSON_STACK_LEN;
+		if(i >= s->size){
+			for(size = s->size ? s->size * 2 : JSON_STACK_LEN; size <= i; size *= 2);
+			spill = realloc(s->spill, size / 4);
+			if(spill == NULL)return(0);
+			memset(&spill[s->size / 32], 0, (size - s->size) / 4);
+			s->spill = spill;
+			s->size = size;
+		}
+		w = &s->spill[i >> 5];
+	}
+	*w = (*w & ~((uint64_t)3 << ((i & 31) * 2))) | ((uint64_t)mode << ((i & 31) * 2));
+	return(1);
+}
+
 static int push(struct JSON_struct *jc, int mode){
 /*
-    Push a mode onto the stack. Return false if there is overflow.
+    Push a mode onto the stack. Return false if the spill buffer cannot grow.
 */
     jc->top += 1;
-    if (jc->top >= JSON_STACK_LEN) {
+    JSON_STAT_MAX(max_depth, jc->top);
+    if (!JSON_stack_set(&jc->stack, jc->top, mode)) {
         return false;
     }
-    jc->stack[jc->top] = mode;
-//    printf("MODE: %d\n", mode);
     return true;
 }
 
@@ -211,14 +497,197 @@ static int pop(struct JSON_struct *jc, int mode){
     Pop the stack, assuring that the current mode matches the expectation.
     Return false if there is underflow or if the modes mismatch.
 */
-    if (jc->top < 0 || jc->stack[jc->top] != mode) {
+    if (jc->top < 0 || JSON_stack_get(&jc->stack, jc->top) != mode) {
         return false;
     }
     jc->top -= 1;
     return true;
 }
 
-static void JSON_set_type(int state, uint8_t *start, uint8_t *end, int *len, int *type);
+/*
+    Structural pre-scan. The text is classified 64 bytes at a time into
+    bitmasks, one bit per byte. Inside a string only quotes, backslashes and
+    control characters change the state, outside of values whitespace never
+    does and inside a number digits never do, so the state machine can jump
+    straight to the next byte that matters. Blocks are classified lazily and
+    at most once per pass.
+*/
+struct JSON_blocks{
+	uint8_t *ptr;
+	size_t len;
+	size_t base;
+	uint64_t quote;
+	uint64_t backslash;
+	uint64_t control;
+	uint64_t space;
+	uint64_t digit;
+};
+
+enum skips {
+    S_NONE,   /* every byte matters */
+    S_SPACE,  /* whitespace keeps the state */
+    S_STRING, /* everything but " \ and control characters keeps the state */
+    S_DIGIT,  /* digits keep the state */
+};
+
+#ifndef JSON_NO_PRESCAN
+static int state_skip[NR_STATES] = {
+/*  GO       OK       OB       KE       CO       VA       AR       ST     */
+    S_SPACE, S_SPACE, S_SPACE, S_SPACE, S_SPACE, S_SPACE, S_SPACE, S_STRING,
+/*  ES       U1       U2       U3       U4       MI       ZE       IN     */
+    S_NONE,  S_NONE,  S_NONE,  S_NONE,  S_NONE,  S_NONE,  S_NONE,  S_DIGIT,
+/*  FR       E1       E2       E3       T1 .. N3                         */
+    S_DIGIT, S_NONE,  S_NONE,  S_DIGIT, S_NONE,  S_NONE,  S_NONE,  S_NONE,
+    S_NONE,  S_NONE,  S_NONE,  S_NONE,  S_NONE,  S_NONE
+};
+#endif
+
+static void JSON_classify_scalar(uint8_t *p, struct JSON_blocks *b){
+	uint64_t bit;
+	int i;
+	b->quote = b->backslash = b->control = b->space = b->digit = 0;
+	for(i = 0, bit = 1; i < 64; i++, bit <<= 1){
+		if(p[i] == '\"')b->quote |= bit;
+		else if(p[i] == '\\')b->backslash |= bit;
+		else if(p[i] == ' ')b->space |= bit;
+		else if((p[i] >= '0') && (p[i] <= '9'))b->digit |= bit;
+		else if(p[i] < 0x20){
+			b->control |= bit;
+			if((p[i] == '\t') || (p[i] == '\n') || (p[i] == '\r'))b->space |= bit;
+		}
+	}
+}
+
+#ifdef JSON_SIMD_X86
+__attribute__((target("sse2")))
+static void JSON_classify_sse2(uint8_t *p, struct JSON_blocks *b){
+	__m128i v, q, bs, ctl, sp, tab, nl, cr, zero, nine;
+	uint64_t m;
+	int i;
+	q = _mm_set1_epi8('\"');
+	bs = _mm_set1_epi8('\\');
+	ctl = _mm_set1_epi8(0x1F);
+	sp = _mm_set1_epi8(' ');
+	tab = _mm_set1_epi8('\t');
+	nl = _mm_set1_epi8('\n');
+	cr = _mm_set1_epi8('\r');
+	zero = _mm_set1_epi8('0');
+	nine = _mm_set1_epi8(9);
+	b->quote = b->backslash = b->control = b->space = b->digit = 0;
+	for(i = 0; i < 64; i += 16){
+		v = _mm_loadu_si128((__m128i *)&p[i]);
+		m = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q));
+		b->quote |= m << i;
+		m = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, bs));
+		b->backslash |= m << i;
+		m = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl));
+		b->control |= m << i;
+		m = (uint16_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)), _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr))));
+		b->space |= m << i;
+		m = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(_mm_sub_epi8(v, zero), nine), nine));
+		b->digit |= m << i;
+	}
+}
+
+__attribute__((target("avx2")))
+static void JSON_classify_avx2(uint8_t *p, struct JSON_blocks *b){
+	__m256i v, q, bs, ctl, sp, tab, nl, cr, zero, nine;
+	uint64_t m;
+	int i;
+	q = _mm256_set1_epi8('\"');
+	bs = _mm256_set1_epi8('\\');
+	ctl = _mm256_set1_epi8(0x1F);
+	sp = _mm256_set1_epi8(' ');
+	tab = _mm256_set1_epi8('\t');
+	nl = _mm256_set1_epi8('\n');
+	cr = _mm256_set1_epi8('\r');
+	zero = _mm256_set1_epi8('0');
+	nine = _mm256_set1_epi8(9);
+	b->quote = b->backslash = b->control = b->space = b->digit = 0;
+	for(i = 0; i < 64; i += 32){
+		v = _mm256_loadu_si256((__m256i *)&p[i]);
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, q));
+		b->quote |= m << i;
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bs));
+		b->backslash |= m << i;
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v, ctl), ctl));
+		b->control |= m << i;
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab)), _mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, cr))));
+		b->space |= m << i;
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(_mm256_sub_epi8(v, zero), nine), nine));
+		b->digit |= m << i;
+	}
+}
+#endif
+
+/* set by JSON_dispatch_init */
+static void (*JSON_classify)(uint8_t *p, struct JSON_blocks *b) = JSON_classify_scalar;
+
+static void JSON_blocks_init(struct JSON_blocks *b, uint8_t *ptr, size_t len){
+	b->ptr = ptr;
+	b->len = len;
+	b->base = (size_t)-64;	/* i - base wraps to i + 64, so block 0 is loaded first */
+}
+
+static size_t JSON_skip_blocks(struct JSON_blocks *b, int skip, size_t i){
+	uint8_t tail[64];
+	uint64_t stop;
+	int off;
+	while(i < b->len){
+		if((i - b->base) >= 64){
+			b->base = i & ~(size_t)63;
+			if((b->base + 64) <= b->len){
+				JSON_classify(&b->ptr[b->base], b);
+			}else{
+				memset(tail, 0, sizeof(tail));
+				memcpy(tail, &b->ptr[b->base], b->len - b->base);
+				JSON_classify(tail, b);
+			}
+		}
+		off = i - b->base;
+		if(skip == S_STRING){
+			stop = b->quote | b->backslash | b->control;
+		}else if(skip == S_SPACE){
+			stop = ~b->space;
+		}else{
+			stop = ~b->digit;
+		}
+		stop >>= off;
+		if(stop)return(i + __builtin_ctzll(stop));
+		i = b->base + 64;
+	}
+	return(b->len);
+}
+
+static inline size_t JSON_skip(struct JSON_blocks *b, int state, size_t i){
+/*
+    Return the position of the first byte at or after i that can change
+    the given state. The next byte is checked first, as most runs are
+    empty or short.
+*/
+#ifndef JSON_NO_PRESCAN
+	int c;
+	if(i >= b->len)return(i);
+	c = b->ptr[i];
+	switch(state_skip[state]){
+	case S_SPACE:
+		if(c <= ' ')return(JSON_skip_blocks(b, S_SPACE, i));
+		break;
+	case S_STRING:
+		if((c != '\"') && (c != '\\'))return(JSON_skip_blocks(b, S_STRING, i));
+		break;
+	case S_DIGIT:
+		if((c >= '0') && (c <= '9'))return(JSON_skip_blocks(b, S_DIGIT, i));
+		break;
+	}
+#else
+	(void)b;
+	(void)state;
+#endif
+	return(i);
+}
+
+static void JSON_set_type(int state, uint8_t *start, uint8_t *end, size_t *len, int *type);
 
 /*
 int JSON_check(uint8_t *ptr, int len){
@@ -252,146 +721,4276 @@ int JSON_check(uint8_t *ptr, int len){
 	}
 }*/
 
-int json_check(uint8_t *ptr, int len, json_object_t *object){
+#ifdef JSON_DFA_COMPACT
+/*
+    Compact engine, built with -DJSON_DFA_COMPACT. The character classes are
+    folded into the transition table, which is indexed by state and raw
+    byte and holds one byte per entry: the next state, an action, or an
+    error. A byte costs one load and one compare. The bookkeeping json_check
+    needs (type, start and length of the value) is read off the text once
+    it has been accepted, so the loop only keeps the mode stack and the top
+    level count.
+*/
+
+#define JSON_DFA_ACTION 0x80	/* JSON_DFA_ACTION + n is action -n */
+#define JSON_DFA_ERROR  0xFF
+
+static uint8_t JSON_dfa[NR_STATES][256];
+static pthread_once_t JSON_dfa_once = PTHREAD_ONCE_INIT;
+
+static void JSON_dfa_build(void){
+	int s, c, next_class, next_state;
+	for(s = 0; s < NR_STATES; s++){
+		for(c = 0; c < 256; c++){
+			next_class = (c >= 128) ? C_ETC : ascii_class[c];
+			next_state = (next_class <= ___) ? ___ : state_transition_table[s][next_class];
+			if(next_state == ___){
+				JSON_dfa[s][c] = JSON_DFA_ERROR;
+			}else if(next_state < 0){
+				JSON_dfa[s][c] = JSON_DFA_ACTION - next_state;
+			}else{
+				JSON_dfa[s][c] = next_state;
+			}
+		}
+	}
+}
+
+static int JSON_dfa_action(struct JSON_struct *jc, int action, size_t *count){
+	int mode;
+	switch(action){
+/* empty } */
+	case 9:
+		if(!pop(jc, MODE_KEY))return(0);
+		break;
+/* } */	case 8:
+		if(!pop(jc, MODE_OBJECT))return(0);
+		if(jc->top == 0)(*count)++;
+		break;
+/* ] */	case 7:
+		if(!pop(jc, MODE_ARRAY))return(0);
+		if((jc->top == 0) && (jc->state != AR))(*count)++;
+		break;
+/* { */	case 6:
+		if(!push(jc, MODE_KEY))return(0);
+		jc->state = OB;
+		return(1);
+/* [ */	case 5:
+		if(!push(jc, MODE_ARRAY))return(0);
+		jc->state = AR;
+		return(1);
+/* " */	case 4:
+		if(JSON_stack_get(&jc->stack, jc->top) == MODE_KEY){
+			jc->state = CO;
+			return(1);
+		}
+		break;
+/* , */	case 3:
+		mode = JSON_stack_get(&jc->stack, jc->top);
+		if(mode == MODE_OBJECT){
+			JSON_stack_set(&jc->stack, jc->top, MODE_KEY);
+			jc->state = KE;
+		}else if(mode == MODE_ARRAY){
+			jc->state = VA;
+		}else{
+			return(0);
+		}
+		if(jc->top == 1)(*count)++;
+		return(1);
+/* : */	case 2:
+		if(!pop(jc, MODE_KEY) || !push(jc, MODE_OBJECT))return(0);
+		jc->state = VA;
+		return(1);
+	default:
+		return(0);
+	}
+	jc->state = OK;
+	return(1);
+}
+
+static int JSON_dfa_check(uint8_t *ptr, size_t len, json_object_t *object){
 	struct JSON_struct jc;
-	int i, next_state;
+	struct JSON_blocks b;
+	size_t i, first, last, count;
+	int next_state, ok;
+	pthread_once(&JSON_dfa_once, JSON_dfa_build);
+	jc.state = GO;
+	jc.top = -1;
+	JSON_stack_init(&jc.stack);
+	push(&jc, MODE_DONE);
+	count = 0;
+	JSON_blocks_init(&b, ptr, len);
+	first = JSON_skip(&b, GO, 0);
+	for(i = first; i < len; i = JSON_skip(&b, jc.state, i + 1)){
+		next_state = JSON_dfa[jc.state][ptr[i]];
+		if(next_state < NR_STATES){
+			jc.state = next_state;
+		}else if(!JSON_dfa_action(&jc, next_state - JSON_DFA_ACTION, &count)){
+			jc.state = ___;
+			break;
+		}
+	}
+	ok = (jc.state >= 0) && (state_transition_table[jc.state][C_END] == OK) && pop(&jc, MODE_DONE);
+	JSON_stack_free(&jc.stack);
+	if(!ok)return(0);
+	for(last = len - 1; (ptr[last] == ' ') || (ptr[last] == '\t') || (ptr[last] == '\n') || (ptr[last] == '\r'); last--);
+	object->start = &ptr[first];
+	object->len = last - first + 1;
+	object->count = count;
+	switch(ptr[first]){
+	case '{':
+		object->type = JSON_TYPE_MAP;
+		break;
+	case '[':
+		object->type = JSON_TYPE_ARRAY;
+		break;
+	case '\"':
+		object->type = JSON_TYPE_STRING;
+		break;
+	case 'n':
+		object->type = JSON_TYPE_NULL;
+		break;
+	case 'f':
+		object->type = JSON_TYPE_FALSE;
+		break;
+	case 't':
+		object->type = JSON_TYPE_TRUE;
+		break;
+	default:
+		object->type = JSON_TYPE_INT;
+		for(i = first; i <= last; i++){
+			if((ptr[i] == '.') || (ptr[i] == 'e') || (ptr[i] == 'E'))object->type = JSON_TYPE_DOUBLE;
+		}
+	}
+	return(1);
+}
+#endif
+
+int json_check(uint8_t *ptr, size_t len, json_object_t *object){
+#ifdef JSON_DFA_COMPACT
+	JSON_STATS_PHASE(JSON_PHASE_CHECK);
+	JSON_STAT_ADD(bytes, len);
+	return(JSON_dfa_check(ptr, len, object));
+#else
+	struct JSON_struct jc;
+	struct JSON_blocks b;
+	size_t i;
+	int next_state, ok;
+	JSON_STATS_PHASE(JSON_PHASE_CHECK);
+	JSON_STAT_ADD(bytes, len);
 	jc.state = GO;
 	jc.top = -1;
 	jc.type = JSON_TYPE_ERROR;
 	jc.count = 0;
+	JSON_stack_init(&jc.stack);
 	push(&jc, MODE_DONE);
-	for(i = 0; i < len; i++){
+	JSON_blocks_init(&b, ptr, len);
+	for(i = JSON_skip(&b, jc.state, 0); i < len; i = JSON_skip(&b, jc.state, i + 1)){
+		if(!JSON_checker_char(&jc, &ptr[i])){
+			jc.state = ___;
+			break;
+		}
+	}
+	if(jc.state >= 0){
+		next_state = state_transition_table[jc.state][C_END];
+		if((jc.state != OK) && (next_state == OK)){
+	    		JSON_set_type(jc.state, jc.start, &ptr[len - 1], &jc.len, &jc.type);
+		}
+		jc.state = next_state;
+	}
+	ok = (jc.state == OK) && pop(&jc, MODE_DONE) && (jc.type != JSON_TYPE_ERROR);
+	JSON_stack_free(&jc.stack);
+	if(ok){
+		object->type = jc.type;
+		object->start = jc.start;
+		object->len = jc.len;
+		object->count = jc.count;
+	}
+	return(ok);
+#endif
+}
+
+int json_get(uint8_t *ptr, size_t len, size_t index, json_object_t *key, json_object_t *value){
+	struct JSON_struct jc;
+	struct JSON_blocks b;
+	size_t i;
+	JSON_STATS_PHASE(JSON_PHASE_LOOKUP);
+	JSON_STAT_ADD(rescans, 1);
+	jc.state = GO;
+	jc.top = -1;
+	jc.type = JSON_TYPE_ERROR;
+	jc.count = 0;
+	jc.key_start = NULL;
+	JSON_stack_init(&jc.stack);
+	push(&jc, MODE_DONE);
+	JSON_blocks_init(&b, ptr, len);
+	for(i = JSON_skip(&b, jc.state, 0); i < len; i = JSON_skip(&b, jc.state, i + 1)){
 		if(!JSON_checker_char(&jc, &ptr[i])){
 			jc.state = ___;
 			break;
 		}
+		if((jc.value_type != JSON_TYPE_ERROR) && jc.count && ((jc.count - 1) == index)){
+			if(key != NULL){
+				if(jc.key_start == NULL){
+					key->type = JSON_TYPE_INDEX;
+					key->start = NULL;
+					key->len = 0;
+					key->count = index;
+				}else{
+					key->type = JSON_TYPE_STRING;
+					key->start = jc.key_start;
+					key->len = jc.key_len;
+					key->count = 0;
+				}
+			}
+			value->type = jc.value_type;
+			value->start = jc.value_start;
+			value->len = jc.value_len;
+			value->count = jc.value_count;
+			JSON_stack_free(&jc.stack);
+			JSON_STAT_ADD(bytes, i + 1);
+			return(1);
+		}
+	}
+	JSON_stack_free(&jc.stack);
+	JSON_STAT_ADD(bytes, i);
+	return(0);
+}
+
+int json_get_value(uint8_t *ptr, size_t len, char *key, json_object_t *value){
+	json_object_t table, _key;
+	size_t i;
+	if(!json_check(ptr, len, &table))return(0);
+	if(table.type != JSON_TYPE_MAP)return(0);
+	if(table.count < 1)return(0);
+	for(i = 0; i < table.count; i++){
+		if(!json_get(ptr, len, i, &_key, value))return(0);
+		if(json_isequal(&_key, key))return(1);
+	}
+	return(0);
+}
+
+int json_isequal(json_object_t *jstr, char *str){
+	size_t l;
+	if(jstr->type != JSON_TYPE_STRING)return(0);
+	l = strlen(str);
+	if(jstr->len != (l + 2))return(0);
+	return(!memcmp(jstr->start + 1, str, l));
+}
+
+int json_value_isequal(uint8_t *ptr, size_t len, char *key, char *value){
+	json_object_t table, _key, _value;
+	size_t i;
+	if(!json_check(ptr, len, &table))return(0);
+	if(table.type != JSON_TYPE_MAP)return(0);
+	if(table.count < 1)return(0);
+	for(i = 0; i < table.count; i++){
+		if(!json_get(ptr, len, i, &_key, &_value))return(0);
+		if(json_isequal(&_key, key)){
+			if(json_isequal(&_value, value))return(1);
+			return(0);
+		}
+	}
+	return(0);
+}
+
+/*
+    Files are mapped read only and parsed in place, so a document is never
+    copied into the heap and only the pages the parser touches are resident.
+    The mapping is private and hinted sequential, which lets the kernel read
+    ahead aggressively and drop pages behind the scanner. An empty file gives
+    ptr NULL and len 0.
+*/
+
+int json_file_open(json_file_t *file, const char *path){
+	struct stat st;
+	void *p;
+	file->ptr = NULL;
+	file->len = 0;
+	file->fd = open(path, O_RDONLY);
+	if(file->fd < 0)return(0);
+	if(fstat(file->fd, &st) || !S_ISREG(st.st_mode) || ((uint64_t)st.st_size > SIZE_MAX)){
+		close(file->fd);
+		file->fd = -1;
+		return(0);
+	}
+	if(st.st_size == 0)return(1);
+	p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+	if(p == MAP_FAILED){
+		close(file->fd);
+		file->fd = -1;
+		return(0);
+	}
+	madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+	file->ptr = p;
+	file->len = (size_t)st.st_size;
+	return(1);
+}
+
+void json_file_close(json_file_t *file){
+	if(file->ptr != NULL)munmap(file->ptr, file->len);
+	if(file->fd >= 0)close(file->fd);
+	file->ptr = NULL;
+	file->len = 0;
+	file->fd = -1;
+}
+
+/*
+    Numbers are decoded in place. The digits are gathered into a 64 bit
+    mantissa w and a decimal exponent q so that value = w * 10^q; at most
+    19 significant digits are kept and the rest only set the truncated flag.
+    Integers are exact or rejected on overflow. Doubles take Clinger's fast
+    path when w and 10^q are both exact, then the Eisel-Lemire algorithm on
+    the 128 bit approximations of 5^q below, and fall back to strtod for the
+    few inputs those cannot round (subnormals, ties hidden by truncation).
+*/
+
+struct JSON_number{
+	uint64_t w;
+	int64_t q;
+	int negative;
+	int truncated;
+	int integer;
+};
+
+#define JSON_POW5_MIN (-342)
+#define JSON_POW5_MAX 308
+
+/* 5^q normalised to 128 bits, truncated for q >= 0 and rounded up for q < 0 */
+static const uint64_t JSON_pow5[JSON_POW5_MAX - JSON_POW5_MIN + 1][2] = {
+	{0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL},
+	{0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL},
+	{0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL},
+	{0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL},
+	{0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL},
+	{0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL},
+	{0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL},
+	{0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL},
+	{0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL},
+	{0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL},
+	{0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL},
+	{0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL},
+	{0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL},
+	{0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL},
+	{0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL},
+	{0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL},
+	{0x84a57695fe98746dULL, 0x014bb630f7604b57ULL},
+	{0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL},
+	{0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL},
+	{0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL},
+	{0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL},
+	{0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL},
+	{0xfd00b897478238d0ULL, 0x8920b098955522b4ULL},
+	{0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL},
+	{0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL},
+	{0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL},
+	{0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL},
+	{0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL},
+	{0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL},
+	{0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL},
+	{0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL},
+	{0xeba09271e88d976bULL, 0xf7864a44c633682eULL},
+	{0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL},
+	{0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL},
+	{0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL},
+	{0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL},
+	{0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL},
+	{0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL},
+	{0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL},
+	{0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL},
+	{0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL},
+	{0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL},
+	{0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL},
+	{0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL},
+	{0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL},
+	{0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL},
+	{0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL},
+	{0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL},
+	{0xa37fce126597973cULL, 0xe50ff107bab528a0ULL},
+	{0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL},
+	{0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL},
+	{0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL},
+	{0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL},
+	{0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL},
+	{0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL},
+	{0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL},
+	{0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL},
+	{0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL},
+	{0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL},
+	{0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL},
+	{0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL},
+	{0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL},
+	{0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL},
+	{0x91376c36d99995beULL, 0x23100809b9c21fa1ULL},
+	{0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL},
+	{0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL},
+	{0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL},
+	{0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL},
+	{0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL},
+	{0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL},
+	{0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL},
+	{0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL},
+	{0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL},
+	{0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL},
+	{0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL},
+	{0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL},
+	{0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL},
+	{0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL},
+	{0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL},
+	{0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL},
+	{0xc987434744ac874eULL, 0xa327ffb266b56220ULL},
+	{0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL},
+	{0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL},
+	{0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL},
+	{0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL},
+	{0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL},
+	{0xc0314325637a1939ULL, 0xfa911155fefb5308ULL},
+	{0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL},
+	{0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL},
+	{0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL},
+	{0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL},
+	{0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL},
+	{0xb749faed14125d36ULL, 0xcef980ec671f667bULL},
+	{0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL},
+	{0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL},
+	{0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL},
+	{0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL},
+	{0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL},
+	{0xaecc49914078536dULL, 0x58fae9f773886e18ULL},
+	{0xda7f5bf590966848ULL, 0xaf39a475506a899eULL},
+	{0x888f99797a5e012dULL, 0x6d8406c952429603ULL},
+	{0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL},
+	{0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL},
+	{0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL},
+	{0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL},
+	{0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL},
+	{0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL},
+	{0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL},
+	{0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL},
+	{0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL},
+	{0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL},
+	{0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL},
+	{0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL},
+	{0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL},
+	{0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL},
+	{0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL},
+	{0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL},
+	{0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL},
+	{0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL},
+	{0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL},
+	{0xb913179899f68584ULL, 0x28e2557b59846e3fULL},
+	{0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL},
+	{0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL},
+	{0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL},
+	{0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL},
+	{0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL},
+	{0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL},
+	{0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL},
+	{0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL},
+	{0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL},
+	{0xd77485cb25823ac7ULL, 0x7d633293366b828bULL},
+	{0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL},
+	{0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL},
+	{0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL},
+	{0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL},
+	{0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL},
+	{0xcd795be870516656ULL, 0x67902e276c921f8bULL},
+	{0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL},
+	{0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL},
+	{0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL},
+	{0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL},
+	{0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL},
+	{0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL},
+	{0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL},
+	{0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL},
+	{0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL},
+	{0xef340a98172aace4ULL, 0x86fb897116c87c34ULL},
+	{0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL},
+	{0xbae0a846d2195712ULL, 0x8974836059cca109ULL},
+	{0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL},
+	{0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL},
+	{0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL},
+	{0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL},
+	{0x8e938662882af53eULL, 0x547eb47b7282ee9cULL},
+	{0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL},
+	{0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL},
+	{0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL},
+	{0xae0b158b4738705eULL, 0x9624ab50b148d445ULL},
+	{0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL},
+	{0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL},
+	{0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL},
+	{0xd47487cc8470652bULL, 0x7647c3200069671fULL},
+	{0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL},
+	{0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL},
+	{0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL},
+	{0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL},
+	{0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL},
+	{0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL},
+	{0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL},
+	{0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL},
+	{0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL},
+	{0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL},
+	{0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL},
+	{0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL},
+	{0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL},
+	{0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL},
+	{0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL},
+	{0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL},
+	{0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL},
+	{0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL},
+	{0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL},
+	{0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL},
+	{0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL},
+	{0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL},
+	{0x8c974f7383725573ULL, 0x1e414218c73a13fbULL},
+	{0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL},
+	{0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL},
+	{0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL},
+	{0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL},
+	{0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL},
+	{0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL},
+	{0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL},
+	{0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL},
+	{0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL},
+	{0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL},
+	{0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL},
+	{0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL},
+	{0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL},
+	{0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL},
+	{0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL},
+	{0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL},
+	{0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL},
+	{0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL},
+	{0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL},
+	{0xbe89523386091465ULL, 0xf6bbb397f1135823ULL},
+	{0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL},
+	{0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL},
+	{0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL},
+	{0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL},
+	{0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL},
+	{0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL},
+	{0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL},
+	{0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL},
+	{0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL},
+	{0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL},
+	{0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL},
+	{0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL},
+	{0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL},
+	{0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL},
+	{0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL},
+	{0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL},
+	{0x843610cb4bf160cbULL, 0xcedf722a585139baULL},
+	{0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL},
+	{0xce947a3da6a9273eULL, 0x733d226229feea32ULL},
+	{0x811ccc668829b887ULL, 0x0806357d5a3f525fULL},
+	{0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL},
+	{0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL},
+	{0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL},
+	{0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL},
+	{0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL},
+	{0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL},
+	{0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL},
+	{0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL},
+	{0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL},
+	{0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL},
+	{0xbbe226efb628afeaULL, 0x890489f70a55368bULL},
+	{0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL},
+	{0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL},
+	{0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL},
+	{0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL},
+	{0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL},
+	{0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL},
+	{0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL},
+	{0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL},
+	{0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL},
+	{0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL},
+	{0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL},
+	{0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL},
+	{0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL},
+	{0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL},
+	{0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL},
+	{0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL},
+	{0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL},
+	{0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL},
+	{0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL},
+	{0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL},
+	{0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL},
+	{0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL},
+	{0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL},
+	{0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL},
+	{0xc24452da229b021bULL, 0xfbe85badce996168ULL},
+	{0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL},
+	{0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL},
+	{0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL},
+	{0xed246723473e3813ULL, 0x290123e9aab23b68ULL},
+	{0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL},
+	{0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL},
+	{0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL},
+	{0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL},
+	{0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL},
+	{0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL},
+	{0x8d590723948a535fULL, 0x579c487e5a38ad0eULL},
+	{0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL},
+	{0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL},
+	{0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL},
+	{0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL},
+	{0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL},
+	{0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL},
+	{0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL},
+	{0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL},
+	{0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL},
+	{0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL},
+	{0xcdb02555653131b6ULL, 0x3792f412cb06794dULL},
+	{0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL},
+	{0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL},
+	{0xc8de047564d20a8bULL, 0xf245825a5a445275ULL},
+	{0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL},
+	{0x9ced737bb6c4183dULL, 0x55464dd69685606bULL},
+	{0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL},
+	{0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL},
+	{0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL},
+	{0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL},
+	{0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL},
+	{0x95a8637627989aadULL, 0xdde7001379a44aa8ULL},
+	{0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL},
+	{0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL},
+	{0x9226712162ab070dULL, 0xcab3961304ca70e8ULL},
+	{0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL},
+	{0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL},
+	{0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL},
+	{0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL},
+	{0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL},
+	{0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL},
+	{0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL},
+	{0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL},
+	{0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL},
+	{0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL},
+	{0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL},
+	{0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL},
+	{0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL},
+	{0xcfb11ead453994baULL, 0x67de18eda5814af2ULL},
+	{0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL},
+	{0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL},
+	{0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL},
+	{0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL},
+	{0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL},
+	{0xc612062576589ddaULL, 0x95364afe032a819eULL},
+	{0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL},
+	{0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL},
+	{0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL},
+	{0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL},
+	{0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL},
+	{0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL},
+	{0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL},
+	{0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL},
+	{0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL},
+	{0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL},
+	{0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL},
+	{0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL},
+	{0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL},
+	{0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL},
+	{0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL},
+	{0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL},
+	{0x89705f4136b4a597ULL, 0x31680a88f8953031ULL},
+	{0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL},
+	{0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL},
+	{0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL},
+	{0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL},
+	{0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL},
+	{0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL},
+	{0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL},
+	{0xccccccccccccccccULL, 0xcccccccccccccccdULL},
+	{0x8000000000000000ULL, 0x0000000000000000ULL},
+	{0xa000000000000000ULL, 0x0000000000000000ULL},
+	{0xc800000000000000ULL, 0x0000000000000000ULL},
+	{0xfa00000000000000ULL, 0x0000000000000000ULL},
+	{0x9c40000000000000ULL, 0x0000000000000000ULL},
+	{0xc350000000000000ULL, 0x0000000000000000ULL},
+	{0xf424000000000000ULL, 0x0000000000000000ULL},
+	{0x9896800000000000ULL, 0x0000000000000000ULL},
+	{0xbebc200000000000ULL, 0x0000000000000000ULL},
+	{0xee6b280000000000ULL, 0x0000000000000000ULL},
+	{0x9502f90000000000ULL, 0x0000000000000000ULL},
+	{0xba43b74000000000ULL, 0x0000000000000000ULL},
+	{0xe8d4a51000000000ULL, 0x0000000000000000ULL},
+	{0x9184e72a00000000ULL, 0x0000000000000000ULL},
+	{0xb5e620f480000000ULL, 0x0000000000000000ULL},
+	{0xe35fa931a0000000ULL, 0x0000000000000000ULL},
+	{0x8e1bc9bf04000000ULL, 0x0000000000000000ULL},
+	{0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL},
+	{0xde0b6b3a76400000ULL, 0x0000000000000000ULL},
+	{0x8ac7230489e80000ULL, 0x0000000000000000ULL},
+	{0xad78ebc5ac620000ULL, 0x0000000000000000ULL},
+	{0xd8d726b7177a8000ULL, 0x0000000000000000ULL},
+	{0x878678326eac9000ULL, 0x0000000000000000ULL},
+	{0xa968163f0a57b400ULL, 0x0000000000000000ULL},
+	{0xd3c21bcecceda100ULL, 0x0000000000000000ULL},
+	{0x84595161401484a0ULL, 0x0000000000000000ULL},
+	{0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL},
+	{0xcecb8f27f4200f3aULL, 0x0000000000000000ULL},
+	{0x813f3978f8940984ULL, 0x4000000000000000ULL},
+	{0xa18f07d736b90be5ULL, 0x5000000000000000ULL},
+	{0xc9f2c9cd04674edeULL, 0xa400000000000000ULL},
+	{0xfc6f7c4045812296ULL, 0x4d00000000000000ULL},
+	{0x9dc5ada82b70b59dULL, 0xf020000000000000ULL},
+	{0xc5371912364ce305ULL, 0x6c28000000000000ULL},
+	{0xf684df56c3e01bc6ULL, 0xc732000000000000ULL},
+	{0x9a130b963a6c115cULL, 0x3c7f400000000000ULL},
+	{0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL},
+	{0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL},
+	{0x96769950b50d88f4ULL, 0x1314448000000000ULL},
+	{0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL},
+	{0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL},
+	{0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL},
+	{0xb7abc627050305adULL, 0xf14a3d9e40000000ULL},
+	{0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL},
+	{0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL},
+	{0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL},
+	{0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL},
+	{0x8c213d9da502de45ULL, 0x4526f422cc340000ULL},
+	{0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL},
+	{0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL},
+	{0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL},
+	{0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL},
+	{0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL},
+	{0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL},
+	{0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL},
+	{0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL},
+	{0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL},
+	{0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL},
+	{0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL},
+	{0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL},
+	{0x9f4f2726179a2245ULL, 0x01d762422c946590ULL},
+	{0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL},
+	{0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL},
+	{0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL},
+	{0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL},
+	{0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL},
+	{0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL},
+	{0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL},
+	{0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL},
+	{0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL},
+	{0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL},
+	{0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL},
+	{0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL},
+	{0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL},
+	{0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL},
+	{0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL},
+	{0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL},
+	{0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL},
+	{0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL},
+	{0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL},
+	{0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL},
+	{0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL},
+	{0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL},
+	{0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL},
+	{0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL},
+	{0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL},
+	{0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL},
+	{0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL},
+	{0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL},
+	{0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL},
+	{0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL},
+	{0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL},
+	{0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL},
+	{0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL},
+	{0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL},
+	{0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL},
+	{0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL},
+	{0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL},
+	{0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL},
+	{0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL},
+	{0x924d692ca61be758ULL, 0x593c2626705f9c56ULL},
+	{0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL},
+	{0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL},
+	{0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL},
+	{0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL},
+	{0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL},
+	{0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL},
+	{0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL},
+	{0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL},
+	{0x884134fe908658b2ULL, 0x3109058d147fdcddULL},
+	{0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL},
+	{0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL},
+	{0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL},
+	{0xa6539930bf6bff45ULL, 0x84db8346b786151cULL},
+	{0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL},
+	{0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL},
+	{0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL},
+	{0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL},
+	{0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL},
+	{0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL},
+	{0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL},
+	{0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL},
+	{0x9ae757596946075fULL, 0x3375788de9b06958ULL},
+	{0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL},
+	{0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL},
+	{0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL},
+	{0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL},
+	{0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL},
+	{0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL},
+	{0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL},
+	{0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL},
+	{0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL},
+	{0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL},
+	{0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL},
+	{0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL},
+	{0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL},
+	{0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL},
+	{0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL},
+	{0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL},
+	{0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL},
+	{0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL},
+	{0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL},
+	{0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL},
+	{0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL},
+	{0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL},
+	{0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL},
+	{0x802221226be55a64ULL, 0xc2494954da2c9789ULL},
+	{0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL},
+	{0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL},
+	{0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL},
+	{0x9c69a97284b578d7ULL, 0xff2a760414536efbULL},
+	{0xc38413cf25e2d70dULL, 0xfef5138519684abaULL},
+	{0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL},
+	{0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL},
+	{0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL},
+	{0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL},
+	{0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL},
+	{0xba756174393d88dfULL, 0x94f971119aeef9e4ULL},
+	{0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL},
+	{0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL},
+	{0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL},
+	{0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL},
+	{0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL},
+	{0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL},
+	{0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL},
+	{0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL},
+	{0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL},
+	{0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL},
+	{0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL},
+	{0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL},
+	{0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL},
+	{0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL},
+	{0xa59bc234db398c25ULL, 0x43fab9837e699095ULL},
+	{0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL},
+	{0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL},
+	{0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL},
+	{0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL},
+	{0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL},
+	{0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL},
+	{0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL},
+	{0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL},
+	{0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL},
+	{0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL},
+	{0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL},
+	{0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL},
+	{0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL},
+	{0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL},
+	{0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL},
+	{0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL},
+	{0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL},
+	{0x8fa475791a569d10ULL, 0xf96e017d694487bcULL},
+	{0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL},
+	{0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL},
+	{0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL},
+	{0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL},
+	{0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL},
+	{0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL},
+	{0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL},
+	{0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL},
+	{0x85c7056562757456ULL, 0xf6872d5667844e49ULL},
+	{0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL},
+	{0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL},
+	{0x82a45b450226b39cULL, 0xecc0024661173473ULL},
+	{0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL},
+	{0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL},
+	{0xff290242c83396ceULL, 0x7e67047175a15271ULL},
+	{0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL},
+	{0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL},
+	{0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL},
+	{0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL},
+	{0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL},
+	{0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL},
+	{0x98165af37b2153deULL, 0xc3727a337a8b704aULL},
+	{0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL},
+	{0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL},
+	{0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL},
+	{0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL},
+	{0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL},
+	{0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL},
+	{0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL},
+	{0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL},
+	{0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL},
+	{0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL},
+	{0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL},
+	{0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL},
+	{0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL},
+	{0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL},
+	{0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL},
+	{0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL},
+	{0xd31045a8341ca07cULL, 0x1ede48111209a050ULL},
+	{0x83ea2b892091e44dULL, 0x934aed0aab460432ULL},
+	{0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL},
+	{0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL},
+	{0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL},
+	{0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL},
+	{0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL},
+	{0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL},
+	{0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL},
+	{0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL},
+	{0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL},
+	{0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL},
+	{0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL},
+	{0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL},
+	{0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL},
+	{0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL},
+	{0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL},
+	{0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL},
+	{0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL},
+	{0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL},
+	{0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL},
+	{0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL},
+	{0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL},
+	{0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL},
+	{0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL},
+	{0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL},
+	{0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL},
+	{0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL},
+	{0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL},
+	{0x8533285c936b35deULL, 0xd53a88958f87275fULL},
+	{0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL},
+	{0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL},
+	{0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL},
+	{0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL},
+	{0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL},
+	{0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL},
+	{0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL},
+	{0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL},
+	{0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL},
+	{0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL},
+	{0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL},
+	{0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL},
+	{0x976e41088617ca01ULL, 0xd5be0503e085d813ULL},
+	{0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL},
+	{0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL},
+	{0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL},
+	{0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL},
+	{0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL},
+	{0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL},
+	{0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL},
+	{0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL},
+	{0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL},
+	{0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL},
+	{0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL},
+	{0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL},
+	{0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL},
+	{0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL},
+	{0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL},
+	{0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL},
+	{0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL},
+	{0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL},
+	{0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL},
+	{0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL},
+	{0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL},
+	{0xa0555e361951c366ULL, 0xd7e105bcc332621fULL},
+	{0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL},
+	{0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL},
+	{0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL},
+	{0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL},
+	{0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL},
+	{0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL},
+	{0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL},
+	{0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL},
+	{0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL},
+	{0xbaa718e68396cffdULL, 0xd30560258f54e6baULL},
+	{0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL},
+	{0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL},
+	{0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL},
+	{0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL},
+	{0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL}
+};
+
+static const double JSON_pow10[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int JSON_number_span(json_object_t *ob, uint8_t **ptr, size_t *len){
+	if(ob->type == JSON_TYPE_STRING){
+		if(ob->len < 3)return(0);
+		*ptr = ob->start + 1;
+		*len = ob->len - 2;
+	}else{
+		if(ob->len < 1)return(0);
+		*ptr = ob->start;
+		*len = ob->len;
+	}
+	return(1);
+}
+
+/*
+    Eight digits at a time: the word is checked to hold only ASCII digits
+    and folded to its value with three multiplies, pairing digits, then
+    pairs, then quads.
+*/
+static inline uint64_t JSON_load8(uint8_t *p){
+	uint64_t v;
+	memcpy(&v, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+	return(v);
+}
+
+static inline int JSON_swar_digits(uint64_t v){
+	return(((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+static inline uint64_t JSON_swar_value(uint64_t v){
+	v = ((v & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+	v = ((v & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+	return(((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+
+static int JSON_parse_number(uint8_t *p, size_t len, struct JSON_number *n){
+	uint64_t w, v;
+	int64_t q;
+	size_t i, end, start;
+	int d, e, sign, truncated, integer;
+	w = 0; q = 0;
+	truncated = 0;
+	integer = 1;
+	n->negative = len > 0 && p[0] == '-';
+	i = n->negative;
+	if(i >= len || (unsigned)(p[i] - '0') > 9)return(0);
+	start = i;
+	if(p[i] == '0'){
+		i++;
+	}else{
+		end = len - i > 19 ? i + 19 : len;
+		for(; (i + 8 <= end) && JSON_swar_digits(v = JSON_load8(&p[i])); i += 8){
+			w = w * 100000000 + JSON_swar_value(v);
+		}
+		for(; i < end && (unsigned)(d = p[i] - '0') <= 9; i++){
+			w = w * 10 + d;
+		}
+		for(; i < len && (unsigned)(d = p[i] - '0') <= 9; i++){
+			truncated |= d;
+			q++;
+		}
+	}
+	if(i < len && p[i] == '.'){
+		integer = 0;
+		if(++i >= len || (unsigned)(p[i] - '0') > 9)return(0);
+		e = w ? 19 - (int)((int64_t)(i - 1 - start) - q) : 19;
+		start = i;
+		if(!w){
+			for(; i < len && p[i] == '0'; i++);
+		}
+		end = len - i > (size_t)e ? i + e : len;
+		for(; (i + 8 <= end) && JSON_swar_digits(v = JSON_load8(&p[i])); i += 8){
+			w = w * 100000000 + JSON_swar_value(v);
+		}
+		for(; i < end && (unsigned)(d = p[i] - '0') <= 9; i++){
+			w = w * 10 + d;
+		}
+		q -= (int64_t)(i - start);
+		for(; i < len && (unsigned)(d = p[i] - '0') <= 9; i++){
+			truncated |= d;
+		}
+	}
+	if(i < len && (p[i] | 0x20) == 'e'){
+		integer = 0;
+		sign = 1;
+		if(++i < len && (p[i] == '+' || p[i] == '-')){
+			if(p[i] == '-')sign = -1;
+			i++;
+		}
+		if(i >= len || (unsigned)(p[i] - '0') > 9)return(0);
+		for(e = 0; i < len && (unsigned)(d = p[i] - '0') <= 9; i++){
+			if(e < 100000)e = e * 10 + d;
+		}
+		q += sign * e;
+	}
+	n->w = w;
+	n->q = q;
+	n->truncated = truncated;
+	n->integer = integer;
+	return(i == len);
+}
+
+static inline void JSON_mul128(uint64_t a, uint64_t b, uint64_t *hi, uint64_t *lo){
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 r;
+	r = (unsigned __int128)a * b;
+	*hi = (uint64_t)(r >> 64);
+	*lo = (uint64_t)r;
+#else
+	uint64_t a0, a1, b0, b1, p01, p10, mid;
+	a0 = (uint32_t)a; a1 = a >> 32;
+	b0 = (uint32_t)b; b1 = b >> 32;
+	p01 = a0 * b1;
+	p10 = a1 * b0;
+	mid = ((a0 * b0) >> 32) + (uint32_t)p01 + (uint32_t)p10;
+	*lo = (mid << 32) | (uint32_t)(a0 * b0);
+	*hi = a1 * b1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+}
+
+/* returns 0 when the product is too close to a rounding boundary to decide */
+static int JSON_eisel_lemire(uint64_t w, int64_t q, uint64_t *bits){
+	uint64_t hi, lo, hi2, lo2, m;
+	int lz, upper;
+	int64_t p2;
+	if(w == 0 || q < JSON_POW5_MIN){
+		*bits = 0;
+		return(1);
+	}
+	if(q > JSON_POW5_MAX){
+		*bits = 0x7FF0000000000000ULL;
+		return(1);
+	}
+	lz = __builtin_clzll(w);
+	w <<= lz;
+	JSON_mul128(w, JSON_pow5[q - JSON_POW5_MIN][0], &hi, &lo);
+	if((hi & 0x1FF) == 0x1FF){
+		JSON_mul128(w, JSON_pow5[q - JSON_POW5_MIN][1], &hi2, &lo2);
+		lo += hi2;
+		if(hi2 > lo)hi++;
+	}
+	if(lo == 0xFFFFFFFFFFFFFFFFULL && (q < -27 || q > 55))return(0);
+	upper = (int)(hi >> 63);
+	m = hi >> (upper + 9);
+	p2 = (((152170 + 65536) * q) >> 16) + 63 + upper - lz + 1023;
+	if(p2 <= 0)return(0);
+	if(lo <= 1 && q >= -4 && q <= 23 && (m & 3) == 1 && (m << (upper + 9)) == hi)m &= ~(uint64_t)1;
+	m += m & 1;
+	m >>= 1;
+	if(m >= (uint64_t)2 << 52){
+		m = (uint64_t)1 << 52;
+		p2++;
+	}
+	m &= ~((uint64_t)1 << 52);
+	if(p2 >= 0x7FF){
+		*bits = 0x7FF0000000000000ULL;
+		return(1);
+	}
+	*bits = m | (uint64_t)p2 << 52;
+	return(1);
+}
+
+/* strtod with the token's '.' swapped for the locale's decimal point */
+static int JSON_strtod(uint8_t *p, size_t len, double *value){
+	char buffer[64], *s, point;
+	size_t i;
+	s = len < sizeof(buffer) ? &buffer[0] : malloc(len + 1);
+	if(!s)return(0);
+	point = localeconv()->decimal_point[0];
+	for(i = 0; i < len; i++){
+		s[i] = p[i] == '.' ? point : p[i];
+	}
+	s[len] = 0;
+	*value = strtod(s, NULL);
+	if(s != &buffer[0])free(s);
+	return(1);
+}
+
+static int JSON_to_int(uint8_t *p, size_t len, long long int *value){
+	struct JSON_number n;
+	if(!JSON_parse_number(p, len, &n))return(0);
+	if(!n.integer || n.q)return(0);
+	if(n.w > (uint64_t)INT64_MAX + n.negative)return(0);
+	*value = n.negative && n.w ? -(long long int)(n.w - 1) - 1 : (long long int)n.w;
+	return(1);
+}
+
+static int JSON_to_double(uint8_t *p, size_t len, double *value){
+	struct JSON_number n;
+	uint64_t bits, next;
+	double d;
+	if(!JSON_parse_number(p, len, &n))return(0);
+	if(FLT_EVAL_METHOD == 0 && !n.truncated && n.q >= -22 && n.q <= 22 && n.w <= (1ULL << 53)){
+		d = (double)n.w;
+		d = n.q < 0 ? d / JSON_pow10[-n.q] : d * JSON_pow10[n.q];
+		*value = n.negative ? -d : d;
+		return(1);
+	}
+	if(JSON_eisel_lemire(n.w, n.q, &bits) &&
+	   (!n.truncated || (JSON_eisel_lemire(n.w + 1, n.q, &next) && next == bits))){
+		bits |= (uint64_t)n.negative << 63;
+		memcpy(&d, &bits, sizeof(d));
+	}else if(!JSON_strtod(p, len, &d)){
+		return(0);
+	}
+	*value = d;
+	return(d <= DBL_MAX && d >= -DBL_MAX);
+}
+
+int json_to_int(json_object_t *ob, long long int *value){
+	uint8_t *p;
+	size_t len;
+	JSON_STATS_PHASE(JSON_PHASE_NUMBER);
+	JSON_STAT_ADD(number_decodes, 1);
+	return(JSON_number_span(ob, &p, &len) && JSON_to_int(p, len, value));
+}
+
+int json_to_double(json_object_t *ob, double *value){
+	uint8_t *p;
+	size_t len;
+	JSON_STATS_PHASE(JSON_PHASE_NUMBER);
+	JSON_STAT_ADD(number_decodes, 1);
+	return(JSON_number_span(ob, &p, &len) && JSON_to_double(p, len, value));
+}
+
+long long int json_int(json_object_t *ob){
+	long long int v;
+	double d;
+	if(json_to_int(ob, &v))return(v);
+	if(json_to_double(ob, &d) && d > -9.2e18 && d < 9.2e18)return((long long int)d);
+	return(0);
+}
+
+double json_double(json_object_t *ob){
+	double d;
+	d = 0;
+	json_to_double(ob, &d);
+	return(d);
+}
+
+/*
+    Bulk decoding of an array of numbers, as returned by json_check or
+    json_get, straight into a typed array in one walk: each element is
+    delimited by its number characters and decoded in place, without a
+    json_object_t or a call to the state machine per element. The int
+    variant takes integers only, as json_to_int. Returns 1 when every
+    element was decoded and sets *count to their number; otherwise returns
+    0 and *count is the index of the first element that is not a number,
+    does not fit, or does not find room in out.
+*/
+
+static int JSON_array_numbers(json_object_t *array, void *out, size_t size, size_t *count, int integer){
+	long long int v;
+	uint8_t *p, c;
+	size_t i, t, end, n;
+	int ok;
+	JSON_STATS_PHASE(JSON_PHASE_NUMBER);
+	*count = 0;
+	if((array->type != JSON_TYPE_ARRAY) || (array->len < 2))return(0);
+	p = array->start;
+	end = array->len - 1;
+	for(i = 1, n = 0, ok = 1;; n++){
+		while((i < end) && (p[i] <= ' '))i++;
+		if(i >= end)break;
+		for(t = i; t < end; t++){
+			c = p[t];
+			if(((unsigned)(c - '0') > 9) && (c != '-') && (c != '+') && (c != '.') && ((c | 0x20) != 'e'))break;
+		}
+		if(n >= size){
+			ok = 0;
+		}else if(integer){
+			ok = JSON_to_int(&p[i], t - i, &v);
+			if(ok)((int64_t *)out)[n] = v;
+		}else{
+			ok = JSON_to_double(&p[i], t - i, &((double *)out)[n]);
+		}
+		for(i = t; (i < end) && (p[i] <= ' '); i++);
+		if(!ok || ((i < end) && (p[i] != ',')))break;
+		i++;
+	}
+	JSON_STAT_ADD(number_decodes, n);
+	*count = n;
+	return(ok && (i >= end));
+}
+
+int json_array_to_double(json_object_t *array, double *out, size_t size, size_t *count){
+	return(JSON_array_numbers(array, out, size, count, 0));
+}
+
+int json_array_to_int(json_object_t *array, int64_t *out, size_t size, size_t *count){
+	return(JSON_array_numbers(array, out, size, count, 1));
+}
+
+/*
+    Number formatting. Doubles are printed with Grisu2: the value and the
+    boundaries of its rounding interval are scaled by a cached power of ten
+    into 64 bit fixed point, and digits are generated until the number is
+    unique inside the interval. The output always reads back to the same
+    double and is the shortest in all but a tiny fraction of cases.
+*/
+
+struct JSON_diyfp{
+	uint64_t f;
+	int e;
+};
+
+/* 10^k ~= f * 2^e, for k from -300 to 324 in steps of 8 */
+static const struct{
+	uint64_t f;
+	int e;
+	int k;
+}JSON_cached_pow10[] = {
+	{0xAB70FE17C79AC6CAULL, -1060, -300},
+	{0xFF77B1FCBEBCDC4FULL, -1034, -292},
+	{0xBE5691EF416BD60CULL, -1007, -284},
+	{0x8DD01FAD907FFC3CULL, -980, -276},
+	{0xD3515C2831559A83ULL, -954, -268},
+	{0x9D71AC8FADA6C9B5ULL, -927, -260},
+	{0xEA9C227723EE8BCBULL, -901, -252},
+	{0xAECC49914078536DULL, -874, -244},
+	{0x823C12795DB6CE57ULL, -847, -236},
+	{0xC21094364DFB5637ULL, -821, -228},
+	{0x9096EA6F3848984FULL, -794, -220},
+	{0xD77485CB25823AC7ULL, -768, -212},
+	{0xA086CFCD97BF97F4ULL, -741, -204},
+	{0xEF340A98172AACE5ULL, -715, -196},
+	{0xB23867FB2A35B28EULL, -688, -188},
+	{0x84C8D4DFD2C63F3BULL, -661, -180},
+	{0xC5DD44271AD3CDBAULL, -635, -172},
+	{0x936B9FCEBB25C996ULL, -608, -164},
+	{0xDBAC6C247D62A584ULL, -582, -156},
+	{0xA3AB66580D5FDAF6ULL, -555, -148},
+	{0xF3E2F893DEC3F126ULL, -529, -140},
+	{0xB5B5ADA8AAFF80B8ULL, -502, -132},
+	{0x87625F056C7C4A8BULL, -475, -124},
+	{0xC9BCFF6034C13053ULL, -449, -116},
+	{0x964E858C91BA2655ULL, -422, -108},
+	{0xDFF9772470297EBDULL, -396, -100},
+	{0xA6DFBD9FB8E5B88FULL, -369, -92},
+	{0xF8A95FCF88747D94ULL, -343, -84},
+	{0xB94470938FA89BCFULL, -316, -76},
+	{0x8A08F0F8BF0F156BULL, -289, -68},
+	{0xCDB02555653131B6ULL, -263, -60},
+	{0x993FE2C6D07B7FACULL, -236, -52},
+	{0xE45C10C42A2B3B06ULL, -210, -44},
+	{0xAA242499697392D3ULL, -183, -36},
+	{0xFD87B5F28300CA0EULL, -157, -28},
+	{0xBCE5086492111AEBULL, -130, -20},
+	{0x8CBCCC096F5088CCULL, -103, -12},
+	{0xD1B71758E219652CULL, -77, -4},
+	{0x9C40000000000000ULL, -50, 4},
+	{0xE8D4A51000000000ULL, -24, 12},
+	{0xAD78EBC5AC620000ULL, 3, 20},
+	{0x813F3978F8940984ULL, 30, 28},
+	{0xC097CE7BC90715B3ULL, 56, 36},
+	{0x8F7E32CE7BEA5C70ULL, 83, 44},
+	{0xD5D238A4ABE98068ULL, 109, 52},
+	{0x9F4F2726179A2245ULL, 136, 60},
+	{0xED63A231D4C4FB27ULL, 162, 68},
+	{0xB0DE65388CC8ADA8ULL, 189, 76},
+	{0x83C7088E1AAB65DBULL, 216, 84},
+	{0xC45D1DF942711D9AULL, 242, 92},
+	{0x924D692CA61BE758ULL, 269, 100},
+	{0xDA01EE641A708DEAULL, 295, 108},
+	{0xA26DA3999AEF774AULL, 322, 116},
+	{0xF209787BB47D6B85ULL, 348, 124},
+	{0xB454E4A179DD1877ULL, 375, 132},
+	{0x865B86925B9BC5C2ULL, 402, 140},
+	{0xC83553C5C8965D3DULL, 428, 148},
+	{0x952AB45CFA97A0B3ULL, 455, 156},
+	{0xDE469FBD99A05FE3ULL, 481, 164},
+	{0xA59BC234DB398C25ULL, 508, 172},
+	{0xF6C69A72A3989F5CULL, 534, 180},
+	{0xB7DCBF5354E9BECEULL, 561, 188},
+	{0x88FCF317F22241E2ULL, 588, 196},
+	{0xCC20CE9BD35C78A5ULL, 614, 204},
+	{0x98165AF37B2153DFULL, 641, 212},
+	{0xE2A0B5DC971F303AULL, 667, 220},
+	{0xA8D9D1535CE3B396ULL, 694, 228},
+	{0xFB9B7CD9A4A7443CULL, 720, 236},
+	{0xBB764C4CA7A44410ULL, 747, 244},
+	{0x8BAB8EEFB6409C1AULL, 774, 252},
+	{0xD01FEF10A657842CULL, 800, 260},
+	{0x9B10A4E5E9913129ULL, 827, 268},
+	{0xE7109BFBA19C0C9DULL, 853, 276},
+	{0xAC2820D9623BF429ULL, 880, 284},
+	{0x80444B5E7AA7CF85ULL, 907, 292},
+	{0xBF21E44003ACDD2DULL, 933, 300},
+	{0x8E679C2F5E44FF8FULL, 960, 308},
+	{0xD433179D9C8CB841ULL, 986, 316},
+	{0x9E19DB92B4E31BA9ULL, 1013, 324}
+};
+
+static const char JSON_digits2[201] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static struct JSON_diyfp JSON_diyfp_mul(struct JSON_diyfp x, struct JSON_diyfp y){
+	uint64_t a, b, c, d, ac, bc, ad, bd, mid;
+	struct JSON_diyfp r;
+	a = x.f >> 32; b = x.f & 0xFFFFFFFF;
+	c = y.f >> 32; d = y.f & 0xFFFFFFFF;
+	ac = a * c; bc = b * c; ad = a * d; bd = b * d;
+	mid = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1U << 31);
+	r.f = ac + (ad >> 32) + (bc >> 32) + (mid >> 32);
+	r.e = x.e + y.e + 64;
+	return(r);
+}
+
+static struct JSON_diyfp JSON_diyfp_normalize(struct JSON_diyfp x){
+	int lz;
+	lz = __builtin_clzll(x.f);
+	x.f <<= lz;
+	x.e -= lz;
+	return(x);
+}
+
+static void JSON_grisu2_round(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k){
+	while((rest < dist) && ((delta - rest) >= ten_k) && (((rest + ten_k) < dist) || ((dist - rest) > (rest + ten_k - dist)))){
+		buf[len - 1]--;
+		rest += ten_k;
+	}
+}
+
+/* digits of v into buf, returns their count and sets *k so that v ~= buf * 10^k */
+static int JSON_grisu2(double value, char *buf, int *k){
+	struct JSON_diyfp v, m_plus, m_minus, c, w, w_plus, w_minus, one;
+	uint64_t bits, delta, dist, p2, rest;
+	uint32_t p1, pow10, d;
+	int e, i, n, len, ex;
+	memcpy(&bits, &value, sizeof(bits));
+	ex = (int)(bits >> 52) & 0x7FF;
+	v.f = bits & 0xFFFFFFFFFFFFFULL;
+	if(ex){
+		v.f |= 1ULL << 52;
+		v.e = ex - 1075;
+	}else{
+		v.e = 1 - 1075;
+	}
+	m_plus.f = (v.f << 1) + 1;
+	m_plus.e = v.e - 1;
+	if(((bits & 0xFFFFFFFFFFFFFULL) == 0) && (ex > 1)){
+		m_minus.f = (v.f << 2) - 1;
+		m_minus.e = v.e - 2;
+	}else{
+		m_minus.f = (v.f << 1) - 1;
+		m_minus.e = v.e - 1;
+	}
+	m_plus = JSON_diyfp_normalize(m_plus);
+	m_minus.f <<= m_minus.e - m_plus.e;
+	m_minus.e = m_plus.e;
+	v = JSON_diyfp_normalize(v);
+/*
+    Pick the cached power that brings the exponent of w_plus into
+    [-60, -32], so the integral part fits 32 bits.
+*/
+	e = -60 - m_plus.e - 1;
+	n = (e * 78913) / (1 << 18) + (e > 0);
+	i = (300 + n + 7) / 8;
+	c.f = JSON_cached_pow10[i].f;
+	c.e = JSON_cached_pow10[i].e;
+	*k = -JSON_cached_pow10[i].k;
+	w = JSON_diyfp_mul(v, c);
+	w_minus = JSON_diyfp_mul(m_minus, c);
+	w_plus = JSON_diyfp_mul(m_plus, c);
+	w_minus.f++;
+	w_plus.f--;
+	delta = w_plus.f - w_minus.f;
+	dist = w_plus.f - w.f;
+	one.e = w_plus.e;
+	one.f = 1ULL << -one.e;
+	p1 = (uint32_t)(w_plus.f >> -one.e);
+	p2 = w_plus.f & (one.f - 1);
+	for(n = 1, pow10 = 1; n < 10 && pow10 * 10 <= p1; n++){
+		pow10 *= 10;
+	}
+	len = 0;
+	while(n > 0){
+		d = p1 / pow10;
+		p1 %= pow10;
+		buf[len++] = '0' + d;
+		n--;
+		rest = ((uint64_t)p1 << -one.e) + p2;
+		if(rest <= delta){
+			*k += n;
+			JSON_grisu2_round(buf, len, dist, delta, rest, (uint64_t)pow10 << -one.e);
+			return(len);
+		}
+		pow10 /= 10;
+	}
+	for(;;){
+		p2 *= 10;
+		buf[len++] = '0' + (p2 >> -one.e);
+		p2 &= one.f - 1;
+		delta *= 10;
+		dist *= 10;
+		(*k)--;
+		if(p2 <= delta)break;
+	}
+	JSON_grisu2_round(buf, len, dist, delta, p2, one.f);
+	return(len);
+}
+
+int json_itoa(long long int value, char *buf){
+/*
+    Print value in decimal, two digits at a time. buf needs 21 bytes, the
+    result is NUL terminated and its length returned.
+*/
+	char tmp[20];
+	unsigned long long int u;
+	int i, n;
+	n = 0;
+	u = value < 0 ? 0ULL - (unsigned long long int)value : (unsigned long long int)value;
+	if(value < 0)buf[n++] = '-';
+	i = sizeof(tmp);
+	while(u >= 100){
+		i -= 2;
+		memcpy(&tmp[i], &JSON_digits2[(u % 100) * 2], 2);
+		u /= 100;
+	}
+	if(u >= 10){
+		i -= 2;
+		memcpy(&tmp[i], &JSON_digits2[u * 2], 2);
+	}else{
+		tmp[--i] = '0' + u;
+	}
+	memcpy(&buf[n], &tmp[i], sizeof(tmp) - i);
+	n += sizeof(tmp) - i;
+	buf[n] = 0;
+	return(n);
+}
+
+int json_dtoa(double value, char *buf){
+/*
+    Print value as the shortest JSON number that reads back to the same
+    double. Integral values keep a ".0" so they parse as JSON_TYPE_DOUBLE,
+    large and small magnitudes switch to exponent notation. buf needs 25
+    bytes, the result is NUL terminated and its length returned. NaN and
+    infinity have no JSON form; for them 0 is returned and buf is empty.
+*/
+	char digits[18];
+	int n, k, len, point, e;
+	len = 0;
+	if(!(value <= DBL_MAX && value >= -DBL_MAX)){
+		buf[0] = 0;
+		return(0);
+	}
+	if(signbit(value)){
+		buf[len++] = '-';
+		value = -value;
+	}
+	if(value == 0){
+		memcpy(&buf[len], "0.0", 4);
+		return(len + 3);
+	}
+	n = JSON_grisu2(value, digits, &k);
+	point = n + k;
+	if((k >= 0) && (point <= 15)){
+		/* 1234e7 -> 12340000000.0 */
+		memcpy(&buf[len], digits, n);
+		memset(&buf[len + n], '0', k);
+		len += point;
+		memcpy(&buf[len], ".0", 3);
+		return(len + 2);
+	}
+	if((point > 0) && (point <= 15)){
+		/* 1234e-2 -> 12.34 */
+		memcpy(&buf[len], digits, point);
+		buf[len + point] = '.';
+		memcpy(&buf[len + point + 1], &digits[point], n - point);
+		len += n + 1;
+		buf[len] = 0;
+		return(len);
+	}
+	if((point > -5) && (point <= 0)){
+		/* 1234e-6 -> 0.001234 */
+		buf[len++] = '0';
+		buf[len++] = '.';
+		memset(&buf[len], '0', -point);
+		len -= point;
+		memcpy(&buf[len], digits, n);
+		len += n;
+		buf[len] = 0;
+		return(len);
+	}
+	/* 1234e30 -> 1.234e33 */
+	buf[len++] = digits[0];
+	if(n > 1){
+		buf[len++] = '.';
+		memcpy(&buf[len], &digits[1], n - 1);
+		len += n - 1;
+	}
+	buf[len++] = 'e';
+	e = point - 1;
+	return(len + json_itoa(e, &buf[len]));
+}
+
+/*
+    The tape is a flat index of the whole document built in a single pass.
+    Every key and every value takes one node, written in document order, so
+    len / 2 + 1 nodes are always enough. Object members are stored as a key
+    node followed by its value node. Node 0 is the top level value and
+    node.next is the index of the first node after the subtree, which lets
+    the lookups below skip whole values without touching the text.
+*/
+
+struct JSON_tape_builder{
+	json_tape_t *tape;
+	size_t open;	/* innermost open container, its next links to its parent */
+};
+
+static int JSON_tape_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	struct JSON_tape_builder *tb;
+	json_tape_t *tape;
+	json_node_t *node;
+	tb = (struct JSON_tape_builder *)jc->ctx;
+	tape = tb->tape;
+	if(event == JSON_EVENT_END){
+		node = &tape->node[tb->open];
+		tb->open = node->next;
+		node->len = (start + len) - (tape->ptr + node->offset);
+		node->next = tape->used;
+		return(1);
+	}
+	if(tape->used >= tape->size)return(0);
+	if((event != JSON_EVENT_KEY) && (tb->open != SIZE_MAX)){
+		tape->node[tb->open].count++;
+	}
+	node = &tape->node[tape->used++];
+	node->type = type;
+	node->offset = start - tape->ptr;
+	node->len = len;
+	node->count = 0;
+	node->next = tape->used;
+	if(event == JSON_EVENT_BEGIN){
+		node->next = tb->open;
+		tb->open = tape->used - 1;
+	}
+	return(1);
+}
+
+size_t json_tape_parse(uint8_t *ptr, size_t len, json_tape_t *tape, json_node_t *node, size_t size){
+	struct JSON_struct jc;
+	struct JSON_tape_builder tb;
+	int ok;
+	tape->ptr = ptr;
+	tape->len = len;
+	tape->node = node;
+	tape->size = size;
+	tape->used = 0;
+	tb.tape = tape;
+	tb.open = SIZE_MAX;
+	JSON_scanner_init(&jc, JSON_tape_event, &tb);
+	ok = (JSON_scan(&jc, ptr, len) == (ssize_t)len) && JSON_scanner_end(&jc, &ptr[len]) && !jc.stop;
+	JSON_stack_free(&jc.stack);
+	return(ok ? tape->used : 0);
+}
+
+int json_tape_object(json_tape_t *tape, size_t node, json_object_t *object){
+	json_node_t *n;
+	if(node >= tape->used)return(0);
+	n = &tape->node[node];
+	object->type = n->type;
+	object->start = tape->ptr + n->offset;
+	object->len = n->len;
+	object->count = n->count;
+	return(1);
+}
+
+size_t json_tape_get(json_tape_t *tape, size_t node, size_t index, json_object_t *key, json_object_t *value){
+	json_node_t *n;
+	size_t i, c;
+	if(node >= tape->used)return(0);
+	n = &tape->node[node];
+	if(index >= n->count)return(0);
+	i = node + 1;
+	if(n->type == JSON_TYPE_MAP){
+		for(c = 0; c < index; c++)i = tape->node[i + 1].next;
+		if(key != NULL)json_tape_object(tape, i, key);
+		i++;
+	}else if(n->type == JSON_TYPE_ARRAY){
+		for(c = 0; c < index; c++)i = tape->node[i].next;
+		if(key != NULL){
+			key->type = JSON_TYPE_INDEX;
+			key->start = NULL;
+			key->len = 0;
+			key->count = index;
+		}
+	}else{
+		return(0);
+	}
+	json_tape_object(tape, i, value);
+	return(i);
+}
+
+size_t json_tape_get_value(json_tape_t *tape, size_t node, char *key, json_object_t *value){
+	json_node_t *n, *k;
+	size_t i, c, l;
+	if(node >= tape->used)return(0);
+	n = &tape->node[node];
+	if(n->type != JSON_TYPE_MAP)return(0);
+	l = strlen(key);
+	for(i = node + 1, c = 0; c < n->count; c++, i = tape->node[i + 1].next){
+		k = &tape->node[i];
+		if((k->len == (l + 2)) && !memcmp(tape->ptr + k->offset + 1, key, l)){
+			json_tape_object(tape, i + 1, value);
+			return(i + 1);
+		}
+	}
+	return(0);
+}
+
+/*
+    Arena allocator for the DOM. The arena hands out memory from a caller
+    buffer, or from malloc'd blocks when json_arena_init is given NULL, and
+    everything it handed out is released at once by json_arena_free. A
+    caller buffer is never grown, allocation fails once it is full.
+*/
+
+#define JSON_ARENA_BLOCK 65536
+
+struct JSON_arena_block{
+	struct JSON_arena_block *next;
+	uint64_t data[];
+};
+
+void json_arena_init(json_arena_t *arena, void *buf, size_t size){
+	arena->buf = buf;
+	arena->size = (buf != NULL) ? size : 0;
+	arena->used = 0;
+	arena->blocks = NULL;
+}
+
+void *json_arena_alloc(json_arena_t *arena, size_t size){
+	struct JSON_arena_block *block;
+	size_t pad, n;
+	void *p;
+	size = (size + 7) & ~(size_t)7;
+	pad = (-(uintptr_t)(arena->buf + arena->used)) & 7;
+	if((arena->size < arena->used) || (arena->size - arena->used < pad + size)){
+		if((arena->buf != NULL) && (arena->blocks == NULL))return(NULL);
+		n = (size > JSON_ARENA_BLOCK) ? size : JSON_ARENA_BLOCK;
+		block = malloc(sizeof(struct JSON_arena_block) + n);
+		if(block == NULL)return(NULL);
+		block->next = arena->blocks;
+		arena->blocks = block;
+		arena->buf = (uint8_t *)block->data;
+		arena->size = n;
+		arena->used = 0;
+		pad = 0;
+	}
+	p = arena->buf + arena->used + pad;
+	arena->used += pad + size;
+	return(p);
+}
+
+void json_arena_free(json_arena_t *arena){
+	struct JSON_arena_block *block, *next;
+	if(arena->blocks != NULL){
+		for(block = arena->blocks; block != NULL; block = next){
+			next = block->next;
+			free(block);
+		}
+		arena->buf = NULL;
+		arena->size = 0;
+	}
+	arena->used = 0;
+	arena->blocks = NULL;
+}
+
+/*
+    DOM built in a single pass into an arena. The children of a container
+    sit in one contiguous array in document order, so json_dom_get is a
+    plain index. Objects with JSON_DOM_INDEX members or more also get a
+    table of member pointers sorted by key length and bytes, which
+    json_dom_get_value searches in O(log n). Keys and values are
+    json_object_t slices into the source buffer, nothing is copied, so the
+    source has to outlive the DOM. While parsing, the members of the open
+    containers wait on a scratch stack and are moved into the arena when
+    their container closes.
+*/
+
+#define JSON_DOM_INDEX 16
+
+struct JSON_dom_builder{
+	json_arena_t *arena;
+	json_dom_t *scratch;
+	size_t used;
+	size_t size;
+	size_t *open;
+	size_t top;
+	size_t depth;
+	json_object_t key;
+};
+
+static int JSON_dom_keycmp(const void *a, const void *b){
+	json_dom_t *x, *y;
+	int c;
+	x = *(json_dom_t **)a;
+	y = *(json_dom_t **)b;
+	if(x->key.len != y->key.len)return((x->key.len < y->key.len) ? -1 : 1);
+	c = memcmp(x->key.start, y->key.start, x->key.len);
+	if(c != 0)return(c);
+	/* equal keys keep document order so lookups find the first one */
+	return((x < y) ? -1 : (x > y));
+}
+
+static int JSON_dom_close(struct JSON_dom_builder *db, uint8_t *end){
+	json_dom_t *node;
+	size_t o, n, i;
+	o = db->open[--db->top];
+	node = &db->scratch[o];
+	n = db->used - o - 1;
+	node->value.len = end - node->value.start;
+	node->value.count = n;
+	if(n > 0){
+		node->child = json_arena_alloc(db->arena, n * sizeof(json_dom_t));
+		if(node->child == NULL)return(0);
+		memcpy(node->child, &db->scratch[o + 1], n * sizeof(json_dom_t));
+	}
+	if((node->value.type == JSON_TYPE_MAP) && (n >= JSON_DOM_INDEX)){
+		node->index = json_arena_alloc(db->arena, n * sizeof(json_dom_t *));
+		if(node->index == NULL)return(0);
+		for(i = 0; i < n; i++)node->index[i] = &node->child[i];
+		qsort(node->index, n, sizeof(json_dom_t *), JSON_dom_keycmp);
+	}
+	db->used = o + 1;
+	return(1);
+}
+
+static int JSON_dom_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	struct JSON_dom_builder *db;
+	json_dom_t *node, *parent;
+	void *p;
+	db = (struct JSON_dom_builder *)jc->ctx;
+	if(event == JSON_EVENT_KEY){
+		db->key.type = type;
+		db->key.start = start;
+		db->key.len = len;
+		db->key.count = 0;
+		return(1);
+	}
+	if(event == JSON_EVENT_END)return(JSON_dom_close(db, start + len));
+	if(db->used >= db->size){
+		p = realloc(db->scratch, 2 * db->size * sizeof(json_dom_t));
+		if(p == NULL)return(0);
+		db->scratch = p;
+		db->size *= 2;
+	}
+	node = &db->scratch[db->used];
+	node->value.type = type;
+	node->value.start = start;
+	node->value.len = len;
+	node->value.count = 0;
+	node->child = NULL;
+	node->index = NULL;
+	if(db->top == 0){
+		node->key.type = JSON_TYPE_ERROR;
+		node->key.start = NULL;
+		node->key.len = 0;
+		node->key.count = 0;
+	}else{
+		parent = &db->scratch[db->open[db->top - 1]];
+		if(parent->value.type == JSON_TYPE_MAP){
+			node->key = db->key;
+		}else{
+			node->key.type = JSON_TYPE_INDEX;
+			node->key.start = NULL;
+			node->key.len = 0;
+			node->key.count = db->used - db->open[db->top - 1] - 1;
+		}
+	}
+	if(event == JSON_EVENT_BEGIN){
+		if(db->top >= db->depth){
+			p = realloc(db->open, 2 * db->depth * sizeof(size_t));
+			if(p == NULL)return(0);
+			db->open = p;
+			db->depth *= 2;
+		}
+		db->open[db->top++] = db->used;
+	}
+	db->used++;
+	return(1);
+}
+
+json_dom_t *json_dom_parse(uint8_t *ptr, size_t len, json_arena_t *arena){
+	struct JSON_struct jc;
+	struct JSON_dom_builder db;
+	json_dom_t *root;
+	int ok;
+	db.arena = arena;
+	db.used = 0;
+	db.size = 64;
+	db.top = 0;
+	db.depth = 16;
+	db.scratch = malloc(db.size * sizeof(json_dom_t));
+	db.open = malloc(db.depth * sizeof(size_t));
+	root = NULL;
+	if((db.scratch != NULL) && (db.open != NULL)){
+		JSON_scanner_init(&jc, JSON_dom_event, &db);
+		ok = (JSON_scan(&jc, ptr, len) == (ssize_t)len) && JSON_scanner_end(&jc, &ptr[len]) && !jc.stop;
+		JSON_stack_free(&jc.stack);
+		if(ok && (db.used == 1)){
+			root = json_arena_alloc(arena, sizeof(json_dom_t));
+			if(root != NULL)*root = db.scratch[0];
+		}
+	}
+	free(db.scratch);
+	free(db.open);
+	return(root);
+}
+
+json_dom_t *json_dom_get(json_dom_t *dom, size_t index){
+	if((dom->value.type != JSON_TYPE_MAP) && (dom->value.type != JSON_TYPE_ARRAY))return(NULL);
+	if(index >= dom->value.count)return(NULL);
+	return(&dom->child[index]);
+}
+
+json_dom_t *json_dom_get_value(json_dom_t *dom, char *key){
+	json_dom_t *k;
+	size_t l, i, lo, hi, mid;
+	int c;
+	if(dom->value.type != JSON_TYPE_MAP)return(NULL);
+	l = strlen(key);
+	if(dom->index == NULL){
+		for(i = 0; i < dom->value.count; i++){
+			k = &dom->child[i];
+			if((k->key.len == (l + 2)) && !memcmp(k->key.start + 1, key, l))return(k);
+		}
+		return(NULL);
+	}
+	lo = 0;
+	hi = dom->value.count;
+	while(lo < hi){
+		mid = lo + (hi - lo) / 2;
+		k = dom->index[mid];
+		if(k->key.len != (l + 2)){
+			c = (k->key.len < (l + 2)) ? -1 : 1;
+		}else{
+			c = memcmp(k->key.start + 1, key, l);
+		}
+		if(c < 0){
+			lo = mid + 1;
+		}else{
+			hi = mid;
+		}
+	}
+	if(lo >= dom->value.count)return(NULL);
+	k = dom->index[lo];
+	if((k->key.len == (l + 2)) && !memcmp(k->key.start + 1, key, l))return(k);
+	return(NULL);
+}
+
+/*
+    Cursor over the elements of one container. The cursor keeps the state
+    and innermost mode of the scanner between elements, so each call to
+    json_cursor_next continues where the previous element ended and a full
+    iteration is a single pass over the container text. Any object or array
+    returned by json_check, json_get or the tape can be used as a root.
+*/
+
+/*
+    Members of the container at depth 0, collected from scanner events.
+    JSON_member_event returns 1 once m->value holds a complete member, with
+    the key (if any) in m->key and the child count in m->value.count.
+*/
+struct JSON_member{
+	json_object_t key;
+	json_object_t value;
+	uint8_t *start;
+};
+
+static int JSON_member_event(struct JSON_member *m, struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	if(jc->top == 2){
+		if((event == JSON_EVENT_BEGIN) || (event == JSON_EVENT_VALUE))m->value.count++;
+		return(0);
+	}
+	if(jc->top != 1)return(0);
+	switch(event){
+	case JSON_EVENT_KEY:
+		m->key.type = JSON_TYPE_STRING;
+		m->key.start = start;
+		m->key.len = len;
+		m->key.count = 0;
+		return(0);
+	case JSON_EVENT_BEGIN:
+		m->start = start;
+		m->value.count = 0;
+		return(0);
+	case JSON_EVENT_END:
+		m->value.type = type;
+		m->value.start = m->start;
+		m->value.len = (start + len) - m->start;
+		return(1);
+	}
+	m->value.type = type;
+	m->value.start = start;
+	m->value.len = len;
+	m->value.count = 0;
+	return(1);
+}
+
+struct JSON_cursor_ctx{
+	struct JSON_member m;
+	int found;
+};
+
+static int JSON_cursor_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	struct JSON_cursor_ctx *cc;
+	cc = (struct JSON_cursor_ctx *)jc->ctx;
+	if(cc->found)return(1);
+	if(jc->top == 0)return(0);
+	if(!JSON_member_event(&cc->m, jc, event, type, start, len))return(1);
+	cc->found = 1;
+	return(0);
+}
+
+int json_cursor_init(json_cursor_t *cur, json_object_t *container){
+	if((container->start == NULL) || (container->len < 2))return(0);
+	if(container->type == JSON_TYPE_MAP){
+		cur->state = OB;
+		cur->mode = MODE_KEY;
+	}else if(container->type == JSON_TYPE_ARRAY){
+		cur->state = AR;
+		cur->mode = MODE_ARRAY;
+	}else{
+		return(0);
+	}
+	cur->type = container->type;
+	cur->ptr = container->start;
+	cur->len = container->len;
+	cur->pos = 1;
+	cur->index = 0;
+	return(1);
+}
+
+int json_cursor_next(json_cursor_t *cur, json_object_t *key, json_object_t *value){
+	struct JSON_struct jc;
+	struct JSON_cursor_ctx cc;
+	ssize_t n;
+	if(cur->state < 0)return(0);
+	cc.found = 0;
+	JSON_scanner_init(&jc, JSON_cursor_event, &cc);
+	jc.state = cur->state;
+	push(&jc, cur->mode);
+	n = JSON_scan(&jc, cur->ptr + cur->pos, cur->len - cur->pos);
+	JSON_stack_free(&jc.stack);
+	if((n < 0) || !cc.found){
+		cur->state = ___;
+		return(0);
+	}
+	cur->pos += n;
+	if(jc.top == 1){
+		cur->state = jc.state;
+		cur->mode = JSON_stack_get(&jc.stack, 1);
+	}else{
+		cur->state = ___;
+	}
+	if(key != NULL){
+		if(cur->type == JSON_TYPE_ARRAY){
+			key->type = JSON_TYPE_INDEX;
+			key->start = NULL;
+			key->len = 0;
+			key->count = cur->index;
+		}else{
+			*key = cc.m.key;
+		}
+	}
+	*value = cc.m.value;
+	cur->index++;
+	return(1);
+}
+
+/*
+    Fetch several keys of the top level object in one pass. The scan stops
+    as soon as every key has been found, so only the part of the text up to
+    the last requested member is validated. Slots of missing keys are left
+    as JSON_TYPE_ERROR. Returns the number of keys found, or 0 if the text
+    is rejected or is not an object.
+*/
+
+struct JSON_batch_ctx{
+	struct JSON_member m;
+	char **keys;
+	json_keyset_t *ks;
+	json_object_t *values;
+	int n;
+	int slot;
+	int found;
+};
+
+static int JSON_batch_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	struct JSON_batch_ctx *bc;
+	size_t l;
+	int i;
+	bc = (struct JSON_batch_ctx *)jc->ctx;
+	if(jc->top == 0){
+		return(((event == JSON_EVENT_BEGIN) && (type == JSON_TYPE_MAP)) || (event == JSON_EVENT_END));
+	}
+	if((event == JSON_EVENT_KEY) && (jc->top == 1) && (bc->ks != NULL)){
+		bc->slot = json_keyset_lookup(bc->ks, start + 1, len - 2);
+		if((bc->slot >= 0) && (bc->values[bc->slot].type != JSON_TYPE_ERROR))bc->slot = -1;
+	}else if((event == JSON_EVENT_KEY) && (jc->top == 1)){
+		bc->slot = -1;
+		l = len - 2;
+		for(i = 0; i < bc->n; i++){
+			if(bc->values[i].type != JSON_TYPE_ERROR)continue;
+			if(!strncmp(bc->keys[i], (char *)start + 1, l) && !bc->keys[i][l]){
+				bc->slot = i;
+				break;
+			}
+		}
+	}
+	if(!JSON_member_event(&bc->m, jc, event, type, start, len))return(1);
+	if(bc->slot < 0)return(1);
+	if(bc->ks != NULL){
+		for(i = bc->slot; i >= 0; i = bc->ks->next[i]){
+			bc->values[i] = bc->m.value;
+			bc->found++;
+		}
+		bc->slot = -1;
+		return(bc->found < bc->n);
+	}
+	for(i = bc->slot; i < bc->n; i++){
+		if((i == bc->slot) || ((bc->values[i].type == JSON_TYPE_ERROR) && !strcmp(bc->keys[i], bc->keys[bc->slot]))){
+			bc->values[i] = bc->m.value;
+			bc->found++;
+		}
+	}
+	bc->slot = -1;
+	return(bc->found < bc->n);
+}
+
+static int JSON_batch(uint8_t *ptr, size_t len, char **keys, json_keyset_t *ks, int n, json_object_t *values){
+	struct JSON_struct jc;
+	struct JSON_batch_ctx bc;
+	int i, ok;
+	JSON_STATS_PHASE(JSON_PHASE_LOOKUP);
+	for(i = 0; i < n; i++){
+		values[i].type = JSON_TYPE_ERROR;
+		values[i].start = NULL;
+		values[i].len = 0;
+		values[i].count = 0;
+	}
+	if(n < 1)return(0);
+	bc.keys = keys;
+	bc.ks = ks;
+	bc.values = values;
+	bc.n = n;
+	bc.slot = -1;
+	bc.found = 0;
+	JSON_scanner_init(&jc, JSON_batch_event, &bc);
+	ok = (JSON_scan(&jc, ptr, len) >= 0) && (jc.stop || JSON_scanner_end(&jc, &ptr[len]));
+	JSON_stack_free(&jc.stack);
+	return(ok ? bc.found : 0);
+}
+
+int json_get_values(uint8_t *ptr, size_t len, char **keys, int n, json_object_t *values){
+	return(JSON_batch(ptr, len, keys, NULL, n, values));
+}
+
+/*
+    Precompiled key set. json_keyset_init builds a two level perfect hash:
+    the hash of a key picks one of about n / 2 buckets, and every bucket
+    carries a displacement, chosen at init, that sends each of its keys to
+    a free slot of a power of two table. A lookup is one hash of the key
+    text, one displacement read, one table read and one memcmp to confirm.
+    The table has two to eight slots per key plus one displacement per two
+    keys, so its size grows linearly with the set. The hash reads the key
+    eight bytes at a time. Repeated keys in the set are chained through
+    next and all receive the same value. json_get_keyset is
+    json_get_values with the set, hashing each top level key once as the
+    scanner passes it.
+*/
+
+#define JSON_KEYSET_SEEDS 64
+#define JSON_KEYSET_DISP  4096
+
+static uint64_t JSON_keyset_hash(uint64_t seed, const uint8_t *p, size_t l){
+	uint64_t h, w;
+	h = seed ^ (l * 0x9E3779B97F4A7C15ULL);
+	for(; l >= 8; l -= 8, p += 8){
+		memcpy(&w, p, 8);
+		h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+		h ^= h >> 31;
+	}
+	if(l > 0){
+		w = 0;
+		memcpy(&w, p, l);
+		h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+		h ^= h >> 31;
+	}
+	return(h * 0x94D049BB133111EBULL);
+}
+
+static inline size_t JSON_keyset_slot(uint64_t h, uint32_t d, int bits){
+	h = (h ^ (d * 0xD6E8FEB86659FD93ULL)) * 0x9E3779B97F4A7C15ULL;
+	h ^= h >> 29;
+	return((h * 0xBF58476D1CE4E5B9ULL) >> (64 - bits));
+}
+
+/* place every bucket, largest first, or return 0 when one does not fit */
+static int JSON_keyset_place(json_keyset_t *ks, uint64_t *hash, int *head, int *link, int *count, int most){
+	size_t size, s;
+	uint32_t d;
+	int b, k, j, c;
+	size = (size_t)1 << ks->bits;
+	memset(ks->table, 0xff, size * sizeof(int));
+	for(c = most; c > 0; c--){
+		for(b = 0; b < (1 << ks->bucket_bits); b++){
+			if(count[b] != c)continue;
+			for(d = 0; d < JSON_KEYSET_DISP; d++){
+				for(k = head[b]; k >= 0; k = link[k]){
+					s = JSON_keyset_slot(hash[k], d, ks->bits);
+					if(ks->table[s] >= 0)break;
+					ks->table[s] = k;
+				}
+				if(k < 0)break;
+				for(j = head[b]; j != k; j = link[j])ks->table[JSON_keyset_slot(hash[j], d, ks->bits)] = -1;
+			}
+			if(d == JSON_KEYSET_DISP)return(0);
+			ks->disp[b] = d;
+		}
+	}
+	return(1);
+}
+
+int json_keyset_init(json_keyset_t *ks, char **keys, int n){
+	size_t bytes, b;
+	uint64_t *hash;
+	uint8_t *p;
+	int *head, *link, *count;
+	int i, j, k, seed, ok, most, bits;
+	void *t;
+	ks->keys = NULL;
+	ks->table = NULL;
+	if(n < 1)return(0);
+	for(i = 0, bytes = 0; i < n; i++)bytes += strlen(keys[i]) + 1;
+	p = malloc(n * (sizeof(char *) + sizeof(size_t) + sizeof(int)) + bytes);
+	if(p == NULL)return(0);
+	ks->n = n;
+	ks->keys = (char **)p;
+	ks->len = (size_t *)&ks->keys[n];
+	ks->next = (int *)&ks->len[n];
+	p = (uint8_t *)&ks->next[n];
+	for(i = 0; i < n; i++){
+		ks->len[i] = strlen(keys[i]);
+		ks->keys[i] = (char *)p;
+		memcpy(p, keys[i], ks->len[i] + 1);
+		p += ks->len[i] + 1;
+		ks->next[i] = -1;
+	}
+	for(ks->bucket_bits = 1; ((size_t)1 << ks->bucket_bits) < (size_t)n / 2; ks->bucket_bits++);
+	for(bits = 2; ((size_t)1 << bits) < 2 * (size_t)n; bits++);
+	b = (size_t)1 << ks->bucket_bits;
+	hash = malloc(n * sizeof(uint64_t) + (n + 2 * b) * sizeof(int));
+	if(hash == NULL){
+		json_keyset_free(ks);
+		return(0);
+	}
+	link = (int *)&hash[n];
+	head = &link[n];
+	count = &head[b];
+	for(ok = 0, ks->bits = bits; !ok && (ks->bits <= bits + 2); ks->bits++){
+		t = realloc(ks->table, ((size_t)1 << ks->bits) * sizeof(int) + b * sizeof(uint32_t));
+		if(t == NULL)break;
+		ks->table = t;
+		ks->disp = (uint32_t *)&ks->table[(size_t)1 << ks->bits];
+		for(seed = 0; !ok && (seed < JSON_KEYSET_SEEDS); seed++){
+			ks->seed = (seed + 1) * 0xD6E8FEB86659FD93ULL;
+			memset(head, 0xff, b * sizeof(int));
+			memset(count, 0, b * sizeof(int));
+			for(i = 0, most = 0; i < n; i++){
+				if(ks->next[i] == -2)continue;
+				hash[i] = JSON_keyset_hash(ks->seed, (uint8_t *)ks->keys[i], ks->len[i]);
+				j = hash[i] >> (64 - ks->bucket_bits);
+				/* a repeated key stays out of the table, marked with -2 */
+				for(k = head[j]; (k >= 0) && ((hash[k] != hash[i]) || strcmp(ks->keys[k], ks->keys[i])); k = link[k]);
+				if(k >= 0){
+					ks->next[i] = -2;
+					continue;
+				}
+				link[i] = head[j];
+				head[j] = i;
+				if(++count[j] > most)most = count[j];
+			}
+			ok = JSON_keyset_place(ks, hash, head, link, count, most);
+		}
+	}
+	free(hash);
+	if(!ok){
+		json_keyset_free(ks);
+		return(0);
+	}
+	ks->bits--;
+	/* chain each repeat after the first copy, in order */
+	for(i = n - 1; i >= 0; i--){
+		if(ks->next[i] != -2)continue;
+		j = json_keyset_lookup(ks, (uint8_t *)ks->keys[i], ks->len[i]);
+		ks->next[i] = ks->next[j];
+		ks->next[j] = i;
+	}
+	return(1);
+}
+
+void json_keyset_free(json_keyset_t *ks){
+	free(ks->keys);
+	free(ks->table);
+	ks->keys = NULL;
+	ks->table = NULL;
+}
+
+int json_keyset_lookup(json_keyset_t *ks, uint8_t *key, size_t len){
+	uint64_t h;
+	int i;
+	h = JSON_keyset_hash(ks->seed, key, len);
+	i = ks->table[JSON_keyset_slot(h, ks->disp[h >> (64 - ks->bucket_bits)], ks->bits)];
+	if((i < 0) || (ks->len[i] != len) || memcmp(ks->keys[i], key, len))return(-1);
+	return(i);
+}
+
+int json_get_keyset(uint8_t *ptr, size_t len, json_keyset_t *ks, json_object_t *values){
+	return(JSON_batch(ptr, len, ks->keys, ks, ks->n, values));
+}
+
+/*
+    Path lookup. The text is validated once by json_check, after which each
+    level is walked structurally: only string boundaries and bracket depth
+    are tracked to hop from member to member, and the state machine runs
+    again only over the target value. The path is either an RFC 6901
+    pointer ("/items/3/id", with ~0 and ~1 escapes) or a dotted path
+    ("items.3.id"). Keys are compared against the raw key text, as in
+    json_isequal.
+*/
+
+static size_t JSON_skip_string(struct JSON_blocks *b, size_t i){
+/*
+    i is just past the opening quote, returns the offset of the closing one.
+*/
+	for(i = JSON_skip_blocks(b, S_STRING, i); (i < b->len) && (b->ptr[i] == '\\'); i = JSON_skip_blocks(b, S_STRING, i + 2));
+	return(i);
+}
+
+static size_t JSON_skip_member(struct JSON_blocks *b, size_t i){
+/*
+    Returns the offset just past the next comma at depth 0, or 0 if the
+    enclosing container ends first.
+*/
+	int depth;
+	for(depth = 0; i < b->len; i++){
+		switch(b->ptr[i]){
+		case '\"':
+			i = JSON_skip_string(b, i + 1);
+			break;
+		case '{':
+		case '[':
+			depth++;
+			break;
+		case '}':
+		case ']':
+			if(depth-- == 0)return(0);
+			break;
+		case ',':
+			if(depth == 0)return(i + 1);
+			break;
+		}
+	}
+	return(0);
+}
+
+static int JSON_path_equal(uint8_t *key, size_t klen, char *seg, size_t slen, int pointer){
+	size_t i, k;
+	for(i = 0, k = 0; i < slen; i++, k++){
+		if(k >= klen)return(0);
+		if(pointer && (seg[i] == '~')){
+			if((i + 1) >= slen)return(0);
+			i++;
+			if(seg[i] == '0'){
+				if(key[k] != '~')return(0);
+			}else if(seg[i] == '1'){
+				if(key[k] != '/')return(0);
+			}else{
+				return(0);
+			}
+		}else if(key[k] != (uint8_t)seg[i]){
+			return(0);
+		}
+	}
+	return(k == klen);
+}
+
+static int JSON_path_step(json_object_t *container, char *seg, size_t slen, int pointer, json_object_t *value){
+	struct JSON_blocks b;
+	json_cursor_t cur;
+	size_t i, index, kend;
+	JSON_blocks_init(&b, container->start, container->len);
+	cur.type = container->type;
+	cur.ptr = container->start;
+	cur.len = container->len;
+	if(container->type == JSON_TYPE_ARRAY){
+		if((slen < 1) || ((seg[0] == '0') && (slen > 1)))return(0);
+		for(i = 0, index = 0; i < slen; i++){
+			if((seg[i] < '0') || (seg[i] > '9') || (index > (SIZE_MAX - 9) / 10))return(0);
+			index = index * 10 + (seg[i] - '0');
+		}
+		for(i = 1, cur.index = 0; cur.index < index; cur.index++){
+			i = JSON_skip_member(&b, i);
+			if(!i)return(0);
+		}
+		cur.pos = i;
+		cur.state = index ? VA : AR;
+		cur.mode = MODE_ARRAY;
+		return(json_cursor_next(&cur, NULL, value));
+	}
+	if(container->type != JSON_TYPE_MAP)return(0);
+	for(i = 1;;){
+		i = JSON_skip_blocks(&b, S_SPACE, i);
+		if((i >= b.len) || (b.ptr[i] != '\"'))return(0);
+		kend = JSON_skip_string(&b, i + 1);
+		if(JSON_path_equal(&b.ptr[i + 1], kend - i - 1, seg, slen, pointer)){
+			cur.pos = JSON_skip_blocks(&b, S_SPACE, kend + 1) + 1;
+			cur.state = VA;
+			cur.mode = MODE_OBJECT;
+			cur.index = 0;
+			return(json_cursor_next(&cur, NULL, value));
+		}
+		i = JSON_skip_member(&b, kend + 1);
+		if(!i)return(0);
+	}
+}
+
+int json_get_pointer(uint8_t *ptr, size_t len, char *path, json_object_t *value){
+	json_object_t ob;
+	char sep;
+	size_t slen;
+	if(!json_check(ptr, len, &ob))return(0);
+	if(*path == 0){
+		*value = ob;
+		return(1);
+	}
+	sep = '.';
+	if(*path == '/'){
+		sep = '/';
+		path++;
+	}
+	for(;;){
+		for(slen = 0; path[slen] && (path[slen] != sep); slen++);
+		if(!JSON_path_step(&ob, path, slen, sep == '/', &ob))return(0);
+		if(!path[slen])break;
+		path += slen + 1;
+	}
+	*value = ob;
+	return(1);
+}
+
+/*
+    Trusted input. For text already validated elsewhere the grammar check is
+    skipped: values are delimited by tracking only string boundaries and
+    bracket depth, as in the path walk above, and scalars by their first
+    byte. The results match json_check, json_get and json_get_value on
+    valid text. On malformed text they are unspecified but every read stays
+    inside ptr[0..len), and an unterminated string or container fails.
+*/
+
+/* bytes that matter when walking a container, everything else is skipped */
+static const uint8_t JSON_trusted_stop[256] = {
+	['\"'] = 1, ['{'] = 1, ['['] = 1, ['}'] = 1, [']'] = 1, [','] = 1
+};
+
+static size_t JSON_trusted_value(struct JSON_blocks *b, size_t i, json_object_t *ob){
+/*
+    i is at the first byte of a value, returns the offset just past it or
+    0 if it does not end inside the buffer.
+*/
+	uint8_t *p;
+	size_t j, count;
+	int depth;
+	p = b->ptr;
+	if(i >= b->len)return(0);
+	ob->start = &p[i];
+	ob->count = 0;
+	switch(p[i]){
+	case '\"':
+		j = JSON_skip_string(b, i + 1);
+		if(j >= b->len)return(0);
+		ob->type = JSON_TYPE_STRING;
+		ob->len = j + 1 - i;
+		return(j + 1);
+	case '{':
+	case '[':
+		ob->type = (p[i] == '{') ? JSON_TYPE_MAP : JSON_TYPE_ARRAY;
+		j = JSON_skip_blocks(b, S_SPACE, i + 1);
+		count = ((j < b->len) && (p[j] != '}') && (p[j] != ']')) ? 1 : 0;
+		for(depth = 0; j < b->len; j++){
+			while(((j + 4) <= b->len) && !(JSON_trusted_stop[p[j]] | JSON_trusted_stop[p[j + 1]] | JSON_trusted_stop[p[j + 2]] | JSON_trusted_stop[p[j + 3]]))j += 4;
+			while((j < b->len) && !JSON_trusted_stop[p[j]])j++;
+			if(j >= b->len)break;
+			switch(p[j]){
+			case '\"':
+				j = JSON_skip_string(b, j + 1);
+				break;
+			case '{':
+			case '[':
+				depth++;
+				break;
+			case '}':
+			case ']':
+				if(depth-- > 0)break;
+				ob->len = j + 1 - i;
+				ob->count = count;
+				return(j + 1);
+			case ',':
+				if(depth == 0)count++;
+				break;
+			}
+		}
+		return(0);
+	}
+	for(j = i; (j < b->len) && (p[j] > ' ') && (p[j] != ',') && (p[j] != ']') && (p[j] != '}'); j++);
+	ob->len = j - i;
+	switch(p[i]){
+	case 't':
+		ob->type = JSON_TYPE_TRUE;
+		break;
+	case 'f':
+		ob->type = JSON_TYPE_FALSE;
+		break;
+	case 'n':
+		ob->type = JSON_TYPE_NULL;
+		break;
+	default:
+		if((p[i] != '-') && ((p[i] < '0') || (p[i] > '9')))return(0);
+		ob->type = (memchr(&p[i], '.', j - i) || memchr(&p[i], 'e', j - i) || memchr(&p[i], 'E', j - i)) ? JSON_TYPE_DOUBLE : JSON_TYPE_INT;
+	}
+	return(j);
+}
+
+int json_trusted_check(uint8_t *ptr, size_t len, json_object_t *object){
+	struct JSON_blocks b;
+	JSON_blocks_init(&b, ptr, len);
+	return(JSON_trusted_value(&b, JSON_skip_blocks(&b, S_SPACE, 0), object) != 0);
+}
+
+static size_t JSON_trusted_member(struct JSON_blocks *b, size_t i, json_object_t *key){
+/*
+    i is at or before the key of an object member, fills key and returns
+    the offset of its value, or 0 if there is no member there.
+*/
+	size_t kend;
+	i = JSON_skip_blocks(b, S_SPACE, i);
+	if((i >= b->len) || (b->ptr[i] != '\"'))return(0);
+	kend = JSON_skip_string(b, i + 1);
+	key->type = JSON_TYPE_STRING;
+	key->start = &b->ptr[i];
+	key->len = kend + 1 - i;
+	key->count = 0;
+	i = JSON_skip_blocks(b, S_SPACE, kend + 1);
+	if((i >= b->len) || (b->ptr[i] != ':'))return(0);
+	return(JSON_skip_blocks(b, S_SPACE, i + 1));
+}
+
+int json_trusted_get(uint8_t *ptr, size_t len, size_t index, json_object_t *key, json_object_t *value){
+	struct JSON_blocks b;
+	json_object_t k;
+	size_t i, n;
+	int type;
+	JSON_blocks_init(&b, ptr, len);
+	i = JSON_skip_blocks(&b, S_SPACE, 0);
+	if((i >= len) || ((ptr[i] != '{') && (ptr[i] != '[')))return(0);
+	type = (ptr[i] == '{') ? JSON_TYPE_MAP : JSON_TYPE_ARRAY;
+	for(i++, n = 0; n < index; n++){
+		i = JSON_skip_member(&b, i);
+		if(!i)return(0);
+	}
+	if(type == JSON_TYPE_MAP){
+		i = JSON_trusted_member(&b, i, &k);
+		if(!i)return(0);
+	}else{
+		i = JSON_skip_blocks(&b, S_SPACE, i);
+		if((i >= len) || (ptr[i] == ']'))return(0);
+		k.type = JSON_TYPE_INDEX;
+		k.start = NULL;
+		k.len = 0;
+		k.count = index;
+	}
+	if(!JSON_trusted_value(&b, i, value))return(0);
+	if(key != NULL)*key = k;
+	return(1);
+}
+
+int json_trusted_get_value(uint8_t *ptr, size_t len, char *key, json_object_t *value){
+	struct JSON_blocks b;
+	json_object_t k;
+	size_t i, l, v;
+	JSON_blocks_init(&b, ptr, len);
+	i = JSON_skip_blocks(&b, S_SPACE, 0);
+	if((i >= len) || (ptr[i] != '{'))return(0);
+	l = strlen(key);
+	for(i++;;){
+		v = JSON_trusted_member(&b, i, &k);
+		if(!v)return(0);
+		if((k.len == (l + 2)) && !memcmp(k.start + 1, key, l))return(JSON_trusted_value(&b, v, value) != 0);
+		i = JSON_skip_member(&b, v);
+		if(!i)return(0);
+	}
+}
+
+/*
+    Push parser. Every token is reported in document order through the
+    callbacks in json_sax_t as the scanner passes it, in a single pass and
+    without copying: keys, strings and numbers are passed as json_object_t
+    slices of the input, ready for json_isequal, json_int or json_double.
+    Callbacks left NULL are skipped. A callback returns 0 to abort.
+*/
+
+struct JSON_sax_ctx{
+	json_sax_t *sax;
+	void *ctx;
+};
+
+static int JSON_sax_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	struct JSON_sax_ctx *sc;
+	json_sax_t *sax;
+	json_object_t ob;
+	sc = (struct JSON_sax_ctx *)jc->ctx;
+	sax = sc->sax;
+	ob.type = type;
+	ob.start = start;
+	ob.len = len;
+	ob.count = 0;
+	switch(event){
+	case JSON_EVENT_BEGIN:
+		if(type == JSON_TYPE_MAP)return((sax->start_object == NULL) || sax->start_object(sc->ctx));
+		return((sax->start_array == NULL) || sax->start_array(sc->ctx));
+	case JSON_EVENT_END:
+		if(type == JSON_TYPE_MAP)return((sax->end_object == NULL) || sax->end_object(sc->ctx));
+		return((sax->end_array == NULL) || sax->end_array(sc->ctx));
+	case JSON_EVENT_KEY:
+		return((sax->key == NULL) || sax->key(sc->ctx, &ob));
+	}
+	switch(type){
+	case JSON_TYPE_NULL:
+		return((sax->null == NULL) || sax->null(sc->ctx));
+	case JSON_TYPE_FALSE:
+	case JSON_TYPE_TRUE:
+		return((sax->boolean == NULL) || sax->boolean(sc->ctx, type == JSON_TYPE_TRUE));
+	case JSON_TYPE_STRING:
+		return((sax->string == NULL) || sax->string(sc->ctx, &ob));
+	case JSON_TYPE_INT:
+		return((sax->integer == NULL) || sax->integer(sc->ctx, &ob));
+	case JSON_TYPE_DOUBLE:
+		return((sax->real == NULL) || sax->real(sc->ctx, &ob));
+	}
+	return(0);
+}
+
+int json_sax_parse(uint8_t *ptr, size_t len, json_sax_t *sax, void *ctx){
+	struct JSON_struct jc;
+	struct JSON_sax_ctx sc;
+	int ok;
+	sc.sax = sax;
+	sc.ctx = ctx;
+	JSON_scanner_init(&jc, JSON_sax_event, &sc);
+	ok = (JSON_scan(&jc, ptr, len) == (ssize_t)len) && !jc.stop && JSON_scanner_end(&jc, &ptr[len]) && !jc.stop;
+	JSON_stack_free(&jc.stack);
+	return(ok);
+}
+
+/*
+    Incremental parser for chunked input. The state machine and its stack
+    live in the stream between calls to json_stream_feed, and every top
+    level value is handed to the callback as soon as its last byte arrives.
+    Values that lie within one chunk are passed without copying. Only the
+    part of a value that spans a chunk boundary is carried over in an
+    internal buffer, so memory is bounded by the largest single value
+    rather than by the whole stream. Top level values may follow each
+    other separated by whitespace, as in a socket message stream.
+*/
+
+struct json_stream{
+	struct JSON_struct jc;
+	int (*value)(void *ctx, json_object_t *value);
+	void *ctx;
+	uint8_t *chunk;
+	uint8_t *vstart;
+	uint8_t *buf;
+	size_t buf_len;
+	size_t buf_size;
+	size_t max;
+	size_t count;
+	int error;
+};
+
+static int JSON_stream_carry(json_stream_t *js, uint8_t *ptr, size_t len){
+	uint8_t *buf;
+	size_t size;
+	if((js->max > 0) && ((js->buf_len + len) > js->max))return(0);
+	if((js->buf_len + len) > js->buf_size){
+		size = js->buf_size ? js->buf_size : 4096;
+		while(size < (js->buf_len + len))size *= 2;
+		buf = realloc(js->buf, size);
+		if(buf == NULL)return(0);
+		js->buf = buf;
+		js->buf_size = size;
+	}
+	memcpy(js->buf + js->buf_len, ptr, len);
+	js->buf_len += len;
+	return(1);
+}
+
+static int JSON_stream_emit(json_stream_t *js, int type, uint8_t *end){
+	json_object_t value;
+	value.type = type;
+	value.count = js->count;
+	if(js->vstart == NULL){
+		if(!JSON_stream_carry(js, js->chunk, end - js->chunk))return(0);
+		value.start = js->buf;
+		value.len = js->buf_len;
+	}else{
+		value.start = js->vstart;
+		value.len = end - js->vstart;
+	}
+	js->buf_len = 0;
+	js->count = 0;
+	return(js->value(js->ctx, &value));
+}
+
+static int JSON_stream_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	json_stream_t *js;
+	js = (json_stream_t *)jc->ctx;
+	if(jc->top == 1){
+		if((event == JSON_EVENT_BEGIN) || (event == JSON_EVENT_VALUE))js->count++;
+	}else if(jc->top == 0){
+		if((event == JSON_EVENT_END) || (event == JSON_EVENT_VALUE)){
+			return(JSON_stream_emit(js, type, start + len));
+		}
+	}
+	return(1);
+}
+
+json_stream_t *json_stream_init(size_t max, int (*value)(void *ctx, json_object_t *value), void *ctx){
+	json_stream_t *js;
+	js = malloc(sizeof(json_stream_t));
+	if(js == NULL)return(NULL);
+	memset(js, 0, sizeof(json_stream_t));
+	js->value = value;
+	js->ctx = ctx;
+	js->max = max;
+	JSON_scanner_init(&js->jc, JSON_stream_event, js);
+	return(js);
+}
+
+int json_stream_feed(json_stream_t *js, uint8_t *ptr, size_t len){
+	struct JSON_blocks b;
+	size_t i;
+	int state;
+	if(js->error)return(0);
+	JSON_STAT_ADD(bytes, len);
+	js->chunk = ptr;
+	if(js->jc.state != GO){
+		js->vstart = NULL;
+		js->jc.start = ptr;
+	}
+	JSON_blocks_init(&b, ptr, len);
+	for(i = JSON_skip(&b, js->jc.state, 0); i < len; i = JSON_skip(&b, js->jc.state, i + 1)){
+		state = js->jc.state;
+		if(!JSON_scanner_char(&js->jc, &ptr[i]) || js->jc.stop){
+			js->error = 1;
+			return(0);
+		}
+		if((state == GO) && (js->jc.state != GO)){
+			js->vstart = &ptr[i];
+		}
+		if((js->jc.state == OK) && (js->jc.top == 0)){
+			js->jc.state = GO;
+		}
+	}
+	if(js->jc.state != GO){
+		if(!JSON_stream_carry(js, js->vstart ? js->vstart : ptr, &ptr[len] - (js->vstart ? js->vstart : ptr))){
+			js->error = 1;
+			return(0);
+		}
+	}
+	return(1);
+}
+
+int json_stream_finish(json_stream_t *js){
+/*
+    Flush a number that ends the stream and release the stream. Returns 0
+    if the stream was rejected or ends inside a value.
+*/
+	json_object_t value;
+	size_t len;
+	int ok, type;
+	ok = !js->error;
+	if(ok && (js->jc.state != GO)){
+		ok = JSON_IS_NUMBER(js->jc.state) && (js->jc.top == 0);
+		if(ok){
+			JSON_set_type(js->jc.state, js->buf, &js->buf[js->buf_len - 1], &len, &type);
+			value.type = type;
+			value.start = js->buf;
+			value.len = len;
+			value.count = 0;
+			ok = js->value(js->ctx, &value);
+		}
+	}
+	JSON_stack_free(&js->jc.stack);
+	free(js->buf);
+	free(js);
+	return(ok);
+}
+
+/*
+    NDJSON. The input is cut into batches of about nd->batch bytes that end
+    on a newline; finding those cuts is the only serial work. Workers take
+    batches in order, split them into lines with the vectorised newline
+    scan, validate every line and run the record callback on it. The
+    calling thread emits finished batches strictly in input order, so at
+    most a ring of 4 batches per worker is in flight at any time. A raw
+    newline can not appear inside a valid JSON value, so every newline is a
+    record boundary.
+*/
+
+static size_t JSON_newline_scan_scalar(const uint8_t *p, size_t n){
+	size_t i;
+	for(i = 0; (i < n) && (p[i] != '\n'); i++);
+	return(i);
+}
+
+#ifdef JSON_SIMD_X86
+__attribute__((target("sse2")))
+static size_t JSON_newline_scan_sse2(const uint8_t *p, size_t n){
+	__m128i nl;
+	size_t i;
+	int m;
+	nl = _mm_set1_epi8('\n');
+	for(i = 0; i + 16 <= n; i += 16){
+		m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)&p[i]), nl));
+		if(m)return(i + __builtin_ctz(m));
+	}
+	return(i + JSON_newline_scan_scalar(&p[i], n - i));
+}
+
+__attribute__((target("avx2")))
+static size_t JSON_newline_scan_avx2(const uint8_t *p, size_t n){
+	__m256i nl;
+	size_t i;
+	uint32_t m;
+	nl = _mm256_set1_epi8('\n');
+	for(i = 0; i + 32 <= n; i += 32){
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)&p[i]), nl));
+		if(m)return(i + __builtin_ctz(m));
+	}
+	return(i + JSON_newline_scan_scalar(&p[i], n - i));
+}
+#endif
+
+/* set by JSON_dispatch_init */
+static size_t (*JSON_newline_scan)(const uint8_t *p, size_t n) = JSON_newline_scan_scalar;
+
+struct JSON_batch{
+	uint8_t *ptr;
+	size_t len;
+	json_object_t *records;
+	uint8_t *ok;
+	uint8_t *results;
+	size_t count;
+	size_t size;
+	int done;
+	int error;
+};
+
+struct JSON_pool{
+	json_ndjson_t *nd;
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	struct JSON_batch *ring;
+	size_t ring_size;
+	size_t next;
+	size_t tail;
+	int quit;
+};
+
+static int JSON_batch_grow(struct JSON_batch *b, size_t result_size){
+	json_object_t *records;
+	uint8_t *ok, *results;
+	size_t size;
+	size = b->size ? b->size * 2 : 256;
+	records = realloc(b->records, size * sizeof(json_object_t));
+	if(records == NULL)return(0);
+	b->records = records;
+	ok = realloc(b->ok, size);
+	if(ok == NULL)return(0);
+	b->ok = ok;
+	if(result_size){
+		results = realloc(b->results, size * result_size);
+		if(results == NULL)return(0);
+		b->results = results;
+	}
+	b->size = size;
+	return(1);
+}
+
+static void JSON_batch_run(json_ndjson_t *nd, struct JSON_batch *b){
+	json_object_t *ob;
+	uint8_t *p, *end, *line;
+	uint8_t *result;
+	size_t n, l;
+	int ok;
+	p = b->ptr;
+	end = b->ptr + b->len;
+	b->count = 0;
+	while(p < end){
+		n = JSON_newline_scan(p, end - p);
+		line = p;
+		l = n;
+		p += n + 1;
+		while(l && ((*line == ' ') || (*line == '\t') || (*line == '\r'))){
+			line++;
+			l--;
+		}
+		while(l && ((line[l - 1] == ' ') || (line[l - 1] == '\t') || (line[l - 1] == '\r')))l--;
+		if(!l)continue;
+		if((b->count == b->size) && !JSON_batch_grow(b, nd->result_size)){
+			b->error = 1;
+			return;
+		}
+		ob = &b->records[b->count];
+		result = nd->result_size ? &b->results[b->count * nd->result_size] : NULL;
+		if(result)memset(result, 0, nd->result_size);
+		ok = json_check(line, l, ob);
+		if(!ok){
+			ob->type = JSON_TYPE_ERROR;
+			ob->count = 0;
+		}else if(nd->record){
+			ok = nd->record(nd->ctx, ob, result) != 0;
+		}
+		ob->start = line;
+		ob->len = l;
+		b->ok[b->count++] = ok;
+	}
+}
+
+static void *JSON_pool_worker(void *arg){
+	struct JSON_pool *pool;
+	struct JSON_batch *b;
+	pool = (struct JSON_pool *)arg;
+	pthread_mutex_lock(&pool->lock);
+	for(;;){
+		while(!pool->quit && (pool->next == pool->tail)){
+			pthread_cond_wait(&pool->work, &pool->lock);
+		}
+		if(pool->quit)break;
+		b = &pool->ring[pool->next++ % pool->ring_size];
+		pthread_mutex_unlock(&pool->lock);
+		JSON_batch_run(pool->nd, b);
+		pthread_mutex_lock(&pool->lock);
+		b->done = 1;
+		pthread_cond_broadcast(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return(NULL);
+}
+
+int json_ndjson_parse(json_ndjson_t *nd, uint8_t *ptr, size_t len){
+/*
+    Run nd over the newline delimited records in ptr. Empty lines are
+    skipped. Returns 1 once every record was emitted, 0 if emit stopped
+    the run or threads or memory could not be had.
+*/
+	struct JSON_pool pool;
+	struct JSON_batch *b;
+	pthread_t *threads;
+	size_t pos, end, head, batch, i;
+	int n, started, ok;
+	n = nd->threads > 0 ? nd->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(n < 1)n = 1;
+	batch = nd->batch ? nd->batch : (1 << 20);
+	memset(&pool, 0, sizeof(pool));
+	pool.nd = nd;
+	pool.ring_size = 4 * n;
+	pool.ring = calloc(pool.ring_size, sizeof(struct JSON_batch));
+	threads = calloc(n, sizeof(pthread_t));
+	if((pool.ring == NULL) || (threads == NULL)){
+		free(pool.ring);
+		free(threads);
+		return(0);
+	}
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.work, NULL);
+	pthread_cond_init(&pool.done, NULL);
+	for(started = 0; started < n; started++){
+		if(pthread_create(&threads[started], NULL, JSON_pool_worker, &pool))break;
+	}
+	ok = started > 0;
+	pos = head = 0;
+	pthread_mutex_lock(&pool.lock);
+	while(ok && ((pos < len) || (head < pool.tail))){
+		while((pos < len) && ((pool.tail - head) < pool.ring_size)){
+			end = (len - pos) > batch ? pos + batch : len;
+			if(end < len)end += JSON_newline_scan(&ptr[end], len - end) + 1;
+			if(end > len)end = len;
+			b = &pool.ring[pool.tail % pool.ring_size];
+			b->ptr = &ptr[pos];
+			b->len = end - pos;
+			b->done = 0;
+			pool.tail++;
+			pos = end;
+			pthread_cond_signal(&pool.work);
+		}
+		b = &pool.ring[head % pool.ring_size];
+		while(!b->done){
+			pthread_cond_wait(&pool.done, &pool.lock);
+		}
+		pthread_mutex_unlock(&pool.lock);
+		if(b->error)ok = 0;
+		for(i = 0; ok && (i < b->count); i++){
+			ok = nd->emit(nd->ctx, &b->records[i], nd->result_size ? &b->results[i * nd->result_size] : NULL, b->ok[i]);
+		}
+		head++;
+		pthread_mutex_lock(&pool.lock);
+	}
+	pool.quit = 1;
+	pthread_cond_broadcast(&pool.work);
+	pthread_mutex_unlock(&pool.lock);
+	for(n = 0; n < started; n++){
+		pthread_join(threads[n], NULL);
+	}
+	for(i = 0; i < pool.ring_size; i++){
+		free(pool.ring[i].records);
+		free(pool.ring[i].ok);
+		free(pool.ring[i].results);
+	}
+	pthread_cond_destroy(&pool.work);
+	pthread_cond_destroy(&pool.done);
+	pthread_mutex_destroy(&pool.lock);
+	free(pool.ring);
+	free(threads);
+	return(ok);
+}
+
+/*
+    Columnar extraction. Records of a top level array or of an NDJSON
+    stream are scattered in one pass into caller arrays, one per schema
+    column, plus a bitmap per column whose bit r is set when row r has a
+    value of the column type. Members are routed with a key set, so each
+    key of a record is hashed once. Missing members, nulls and values of
+    another type leave the bit clear and the slot zeroed. Only the first of
+    repeated members counts, as in json_get_value. Strings are stored as
+    json_object_t slices of the input, numbers go through json_to_int and
+    json_to_double, and an int column does not take non integral numbers.
+*/
+
+struct JSON_columns_ctx{
+	json_columns_t *cols;
+	int depth;	/* depth of the records */
+	int slot;
+	uint8_t *seen;	/* columns whose member the record already had */
+};
+
+static void JSON_columns_clear(json_columns_t *cols, size_t row){
+	json_column_t *c;
+	int i;
+	for(i = 0; i < cols->n; i++){
+		c = &cols->column[i];
+		c->valid[row >> 3] &= ~(1 << (row & 7));
+		switch(c->type){
+		case JSON_COLUMN_INT:
+			((int64_t *)c->data)[row] = 0;
+			break;
+		case JSON_COLUMN_DOUBLE:
+			((double *)c->data)[row] = 0;
+			break;
+		case JSON_COLUMN_STRING:
+			memset(&((json_object_t *)c->data)[row], 0, sizeof(json_object_t));
+			break;
+		case JSON_COLUMN_BOOL:
+			((uint8_t *)c->data)[row] = 0;
+			break;
+		}
+	}
+}
+
+static void JSON_columns_set(json_column_t *c, size_t row, int type, uint8_t *start, size_t len){
+	json_object_t ob;
+	long long int v;
+	double d;
+	ob.type = type;
+	ob.start = start;
+	ob.len = len;
+	ob.count = 0;
+	switch(c->type){
+	case JSON_COLUMN_INT:
+		if((type != JSON_TYPE_INT) || !json_to_int(&ob, &v))return;
+		((int64_t *)c->data)[row] = v;
+		break;
+	case JSON_COLUMN_DOUBLE:
+		if(((type != JSON_TYPE_INT) && (type != JSON_TYPE_DOUBLE)) || !json_to_double(&ob, &d))return;
+		((double *)c->data)[row] = d;
+		break;
+	case JSON_COLUMN_STRING:
+		if(type != JSON_TYPE_STRING)return;
+		((json_object_t *)c->data)[row] = ob;
+		break;
+	case JSON_COLUMN_BOOL:
+		if((type != JSON_TYPE_TRUE) && (type != JSON_TYPE_FALSE))return;
+		((uint8_t *)c->data)[row] = (type == JSON_TYPE_TRUE);
+		break;
+	default:
+		return;
+	}
+	c->valid[row >> 3] |= 1 << (row & 7);
+}
+
+static int JSON_columns_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	struct JSON_columns_ctx *cc;
+	json_columns_t *cols;
+	int i;
+	cc = (struct JSON_columns_ctx *)jc->ctx;
+	cols = cc->cols;
+	if(jc->top < cc->depth){
+		/* the array around the records */
+		return((event == JSON_EVENT_END) || ((event == JSON_EVENT_BEGIN) && (type == JSON_TYPE_ARRAY)));
+	}
+	if(jc->top == cc->depth){
+		if(event == JSON_EVENT_END){
+			cols->rows++;
+			return(1);
+		}
+		if(cols->rows >= cols->capacity)return(0);
+		JSON_columns_clear(cols, cols->rows);
+		memset(cc->seen, 0, cols->n);
+		cc->slot = -1;
+		/* anything but an object is a row of nulls */
+		if(event == JSON_EVENT_VALUE)cols->rows++;
+		return(1);
+	}
+	if(jc->top != (cc->depth + 1))return(1);
+	if(event == JSON_EVENT_KEY){
+		cc->slot = json_keyset_lookup(&cols->keys, start + 1, len - 2);
+		return(1);
+	}
+	for(i = cc->slot; i >= 0; i = cols->keys.next[i]){
+		if(cc->seen[i])break;
+		cc->seen[i] = 1;
+		if(event == JSON_EVENT_VALUE)JSON_columns_set(&cols->column[i], cols->rows, type, start, len);
+	}
+	cc->slot = -1;
+	return(1);
+}
+
+int json_columns_init(json_columns_t *cols, json_column_t *column, int n, size_t capacity){
+/*
+    column[i].data must hold capacity values of the column type and
+    column[i].valid capacity bits.
+*/
+	char **names;
+	int i, ok;
+	names = malloc(n * sizeof(char *));
+	if(names == NULL)return(0);
+	for(i = 0; i < n; i++)names[i] = column[i].name;
+	ok = json_keyset_init(&cols->keys, names, n);
+	free(names);
+	cols->column = column;
+	cols->n = n;
+	cols->capacity = capacity;
+	cols->rows = 0;
+	return(ok);
+}
+
+void json_columns_free(json_columns_t *cols){
+	json_keyset_free(&cols->keys);
+}
+
+int json_columns_array(json_columns_t *cols, uint8_t *ptr, size_t len){
+/*
+    Appends a row for every element of the top level array. Returns 0 if
+    the text is rejected or there are more records than capacity, the
+    rows appended before that stay.
+*/
+	struct JSON_struct jc;
+	struct JSON_columns_ctx cc;
+	int ok;
+	cc.cols = cols;
+	cc.depth = 1;
+	cc.slot = -1;
+	cc.seen = malloc(cols->n);
+	if(cc.seen == NULL)return(0);
+	JSON_scanner_init(&jc, JSON_columns_event, &cc);
+	ok = (JSON_scan(&jc, ptr, len) == (ssize_t)len) && JSON_scanner_end(&jc, &ptr[len]) && !jc.stop;
+	JSON_stack_free(&jc.stack);
+	free(cc.seen);
+	return(ok);
+}
+
+int json_columns_ndjson(json_columns_t *cols, uint8_t *ptr, size_t len, size_t *used){
+/*
+    Appends a row for every non blank line until the input ends or the
+    columns are full, and sets *used to the bytes taken, so the rest can
+    be fed after the rows are consumed. A line that is rejected is a row
+    of nulls.
+*/
+	struct JSON_struct jc;
+	struct JSON_columns_ctx cc;
+	size_t p, n, i, row;
+	int ok;
+	cc.cols = cols;
+	cc.depth = 0;
+	cc.seen = malloc(cols->n);
+	if(cc.seen == NULL)return(0);
+	for(p = 0; p < len; p += n + 1){
+		n = JSON_newline_scan(&ptr[p], len - p);
+		for(i = 0; (i < n) && (ptr[p + i] <= ' '); i++);
+		if(i == n)continue;
+		if(cols->rows >= cols->capacity)break;
+		row = cols->rows;
+		cc.slot = -1;
+		JSON_scanner_init(&jc, JSON_columns_event, &cc);
+		ok = (JSON_scan(&jc, &ptr[p], n) == (ssize_t)n) && JSON_scanner_end(&jc, &ptr[p + n]) && !jc.stop;
+		JSON_stack_free(&jc.stack);
+		if(!ok || (cols->rows != row + 1)){
+			JSON_columns_clear(cols, row);
+			cols->rows = row + 1;
+		}
+	}
+	free(cc.seen);
+	*used = (p < len) ? p : len;
+	return(1);
+}
+
+/*
+    Queries over NDJSON. A query is a filter, the conjunction of predicates
+    on paths into the record, and a list of paths to project, e.g.
+
+	@.status == "error" && @.latency > 500 && @.tags[*] == "db"
+
+    A path starts at the record with @ (or $) and steps by .name, ['name'],
+    [index], .* or [*], the last two taking any member or element. A
+    predicate is a path alone, which holds when the path exists, or a path
+    compared with ==, !=, <, <=, > or >= to a string, a number, true, false
+    or null. Strings compare by their raw bytes, as in json_isequal,
+    numbers as doubles, and values of different types are only ever
+    unequal. A path with a wildcard holds if any of its values does, for
+    one without the first value decides, as in json_get_value.
+
+    Every path of the query is a bit, and the scanner keeps per level the
+    bits of the paths whose leading steps match where it is, so each key is
+    compared against the paths still alive there only. A record is dropped
+    before it is scanned when it lacks the quoted text of a string that a
+    == predicate asks for, and its scan stops at the first value that
+    decides a predicate false. Records that match are validated to the end.
+    A query holds the state of the record being run, so it serves one
+    thread at a time.
+*/
+
+#define JSON_QUERY_PATHS 64
+
+#define JSON_QUERY_EXISTS 0
+#define JSON_QUERY_EQ     1
+#define JSON_QUERY_NE     2
+#define JSON_QUERY_LE     3
+#define JSON_QUERY_GE     4
+#define JSON_QUERY_LT     5
+#define JSON_QUERY_GT     6
+
+static const char *JSON_query_ops[] = {"", "==", "!=", "<=", ">=", "<", ">"};
+
+struct JSON_query_step{
+	int any;
+	uint8_t *name;	/* NULL for an index */
+	size_t len;	/* name length or index */
+};
+
+struct JSON_query_path{
+	struct JSON_query_step *step;
+	int steps;
+	int op;
+	json_object_t literal;	/* strings without their quotes */
+	double number;
+};
+
+struct JSON_query_level{
+	uint64_t ends;		/* paths that end at this level */
+	uint64_t alive;		/* paths that go on below the container here */
+	uint64_t complete;	/* paths that end at the container here */
+	uint64_t member;	/* paths that take the member after the last key */
+	uint8_t *start;
+	size_t count;
+	int type;
+};
+
+struct JSON_query_value{
+	int path;
+	json_object_t value;
+};
+
+struct json_query{
+	char *text;	/* names and literals point into this copy of the query */
+	struct JSON_query_step *step;
+	size_t steps;
+	struct JSON_query_path path[JSON_QUERY_PATHS];
+	int n;
+	int predicates;	/* the first paths, the rest are projected */
+	int depth;
+	uint64_t all;
+	uint64_t need;	/* the predicates */
+	uint64_t wild;
+	struct JSON_query_level *level;
+	/* the record being run */
+	uint64_t decided;
+	json_object_t record;
+	struct JSON_query_value *value;
+	size_t values;
+	size_t size;
+	int error;
+};
+
+static void JSON_query_space(char **p){
+	while((**p == ' ') || (**p == '\t') || (**p == '\n') || (**p == '\r'))(*p)++;
+}
+
+static int JSON_query_name(char c){
+	return(((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) ||
+		(c == '_') || (c == '-') || ((uint8_t)c >= 128));
+}
+
+static char *JSON_query_quoted(char *p){
+/*
+    p is at an opening ' or ", returns the closing one or NULL. Escapes are
+    skipped but kept, names and strings are matched raw.
+*/
+	char quote;
+	quote = *p;
+	for(p++; *p != quote; p++){
+		if(*p == 0)return(NULL);
+		if((*p == '\\') && (p[1] != 0))p++;
+	}
+	return(p);
+}
+
+static int JSON_query_path(json_query_t *q, char **text){
+	struct JSON_query_path *path;
+	struct JSON_query_step *s;
+	char *p, *e;
+	if(q->n >= JSON_QUERY_PATHS)return(0);
+	path = &q->path[q->n];
+	path->step = &q->step[q->steps];
+	path->steps = 0;
+	path->op = JSON_QUERY_EXISTS;
+	p = *text;
+	JSON_query_space(&p);
+	if((*p != '@') && (*p != '$'))return(0);
+	for(p++; ; path->steps++){
+		s = &path->step[path->steps];
+		s->any = 0;
+		s->name = NULL;
+		s->len = 0;
+		if((p[0] == '.') && (p[1] == '*')){
+			s->any = 1;
+			p += 2;
+		}else if(*p == '.'){
+			for(e = ++p; JSON_query_name(*e); e++);
+			if(e == p)return(0);
+			s->name = (uint8_t *)p;
+			s->len = e - p;
+			p = e;
+		}else if(*p == '['){
+			p++;
+			if(*p == '*'){
+				s->any = 1;
+				p++;
+			}else if((*p == '"') || (*p == '\'')){
+				if((e = JSON_query_quoted(p)) == NULL)return(0);
+				s->name = (uint8_t *)p + 1;
+				s->len = e - p - 1;
+				p = e + 1;
+			}else if((*p >= '0') && (*p <= '9')){
+				for(; (*p >= '0') && (*p <= '9'); p++){
+					if(s->len > ((SIZE_MAX - 9) / 10))return(0);
+					s->len = s->len * 10 + (*p - '0');
+				}
+			}else{
+				return(0);
+			}
+			if(*p++ != ']')return(0);
+		}else{
+			break;
+		}
+		if(s->any)q->wild |= (uint64_t)1 << q->n;
+	}
+	q->steps += path->steps;
+	if(path->steps > q->depth)q->depth = path->steps;
+	q->n++;
+	*text = p;
+	return(1);
+}
+
+static int JSON_query_predicate(json_query_t *q, char **text){
+	struct JSON_query_path *path;
+	char *p, *e;
+	int op;
+	if(!JSON_query_path(q, text))return(0);
+	path = &q->path[q->n - 1];
+	p = *text;
+	JSON_query_space(&p);
+	/* two byte operators first */
+	for(op = JSON_QUERY_EQ; op <= JSON_QUERY_GT; op++){
+		if(!strncmp(p, JSON_query_ops[op], strlen(JSON_query_ops[op])))break;
+	}
+	if(op > JSON_QUERY_GT)return(1);
+	p += strlen(JSON_query_ops[op]);
+	JSON_query_space(&p);
+	path->op = op;
+	path->literal.count = 0;
+	if((*p == '"') || (*p == '\'')){
+		if((e = JSON_query_quoted(p)) == NULL)return(0);
+		/* quoted as in the records, for the text search */
+		*p = *e = '"';
+		path->literal.type = JSON_TYPE_STRING;
+		path->literal.start = (uint8_t *)p + 1;
+		path->literal.len = e - p - 1;
+		p = e + 1;
+	}else if(!strncmp(p, "true", 4) && !JSON_query_name(p[4])){
+		path->literal.type = JSON_TYPE_TRUE;
+		p += 4;
+	}else if(!strncmp(p, "false", 5) && !JSON_query_name(p[5])){
+		path->literal.type = JSON_TYPE_FALSE;
+		p += 5;
+	}else if(!strncmp(p, "null", 4) && !JSON_query_name(p[4])){
+		path->literal.type = JSON_TYPE_NULL;
+		p += 4;
+	}else{
+		for(e = p; (*e != 0) && (strchr("+-.0123456789eE", *e) != NULL); e++);
+		if((e == p) || !JSON_to_double((uint8_t *)p, e - p, &path->number))return(0);
+		path->literal.type = JSON_TYPE_DOUBLE;
+		path->literal.start = (uint8_t *)p;
+		path->literal.len = e - p;
+		p = e;
+	}
+	*text = p;
+	return(1);
+}
+
+static int JSON_query_compare(struct JSON_query_path *path, json_object_t *ob){
+	double d;
+	size_t len;
+	int c;
+	if(path->op == JSON_QUERY_EXISTS)return(1);
+	if((path->literal.type == JSON_TYPE_STRING) && (ob->type == JSON_TYPE_STRING)){
+		len = ob->len - 2;
+		c = memcmp(ob->start + 1, path->literal.start, len < path->literal.len ? len : path->literal.len);
+		if(c == 0)c = (len > path->literal.len) - (len < path->literal.len);
+	}else if((path->literal.type == JSON_TYPE_DOUBLE) && ((ob->type == JSON_TYPE_INT) || (ob->type == JSON_TYPE_DOUBLE))){
+		if(!JSON_to_double(ob->start, ob->len, &d))return(path->op == JSON_QUERY_NE);
+		c = (d > path->number) - (d < path->number);
+	}else if((path->literal.type == ob->type) && (ob->type != JSON_TYPE_STRING) && (ob->type != JSON_TYPE_DOUBLE)){
+		c = 0;
+	}else{
+		return(path->op == JSON_QUERY_NE);
+	}
+	switch(path->op){
+	case JSON_QUERY_EQ:
+		return(c == 0);
+	case JSON_QUERY_NE:
+		return(c != 0);
+	case JSON_QUERY_LE:
+		return(c <= 0);
+	case JSON_QUERY_GE:
+		return(c >= 0);
+	case JSON_QUERY_LT:
+		return(c < 0);
+	case JSON_QUERY_GT:
+		return(c > 0);
+	}
+	return(0);
+}
+
+/* paths of alive whose step at level takes the member key, or the element index */
+static uint64_t JSON_query_key(json_query_t *q, uint64_t alive, size_t level, uint8_t *key, size_t len){
+	struct JSON_query_step *s;
+	uint64_t m;
+	for(m = 0; alive; alive &= alive - 1){
+		s = &q->path[__builtin_ctzll(alive)].step[level];
+		if(s->any || ((s->name != NULL) && (s->len == len) && !memcmp(s->name, key, len)))m |= alive & -alive;
+	}
+	return(m);
+}
+
+static uint64_t JSON_query_index(json_query_t *q, uint64_t alive, size_t level, size_t index){
+	struct JSON_query_step *s;
+	uint64_t m;
+	for(m = 0; alive; alive &= alive - 1){
+		s = &q->path[__builtin_ctzll(alive)].step[level];
+		if(s->any || ((s->name == NULL) && (s->len == index)))m |= alive & -alive;
+	}
+	return(m);
+}
+
+static int JSON_query_match(json_query_t *q, uint64_t m, json_object_t *ob){
+/*
+    ob is a value of the paths in m. Returns 0 to stop the scan, when a
+    predicate fails for good or memory runs out.
+*/
+	struct JSON_query_value *v;
+	uint64_t bit;
+	int p;
+	for(; m; m &= m - 1){
+		p = __builtin_ctzll(m);
+		bit = m & -m;
+		if((q->decided & bit) && ((p < q->predicates) || !(q->wild & bit)))continue;
+		if(p < q->predicates){
+			if(JSON_query_compare(&q->path[p], ob)){
+				q->decided |= bit;
+			}else if(!(q->wild & bit)){
+				return(0);
+			}
+			continue;
+		}
+		q->decided |= bit;
+		if(q->values == q->size){
+			v = realloc(q->value, (q->size ? q->size * 2 : 16) * sizeof(struct JSON_query_value));
+			if(v == NULL){
+				q->error = 1;
+				return(0);
+			}
+			q->value = v;
+			q->size = q->size ? q->size * 2 : 16;
+		}
+		q->value[q->values].path = p;
+		q->value[q->values++].value = *ob;
+	}
+	return(1);
+}
+
+static int JSON_query_event(struct JSON_struct *jc, int event, int type, uint8_t *start, size_t len){
+	json_query_t *q;
+	struct JSON_query_level *at, *up;
+	json_object_t ob;
+	uint64_t m;
+	size_t level;
+	q = (json_query_t *)jc->ctx;
+	level = jc->top;
+	if(level > (size_t)q->depth){
+		/* below every path, only the count of a container at the last level matters */
+		if((level == (size_t)q->depth + 1) && (event != JSON_EVENT_KEY) && (event != JSON_EVENT_END))q->level[level - 1].count++;
+		return(1);
+	}
+	at = &q->level[level];
+	up = level ? &q->level[level - 1] : NULL;
+	if(event == JSON_EVENT_KEY){
+		up->member = up->alive ? JSON_query_key(q, up->alive, level - 1, start + 1, len - 2) : 0;
+		return(1);
+	}
+	if(event == JSON_EVENT_END){
+		ob.type = type;
+		ob.start = at->start;
+		ob.len = (start + 1) - at->start;
+		ob.count = at->count;
+		if(level == 0)q->record = ob;
+		return(at->complete ? JSON_query_match(q, at->complete, &ob) : 1);
+	}
+	/* a value or the start of a container */
+	if(up == NULL){
+		m = q->all;
+	}else{
+		if(up->type == JSON_TYPE_ARRAY){
+			up->member = up->alive ? JSON_query_index(q, up->alive, level - 1, up->count) : 0;
+		}
+		m = up->member;
+		up->count++;
+	}
+	if(event == JSON_EVENT_BEGIN){
+		at->type = type;
+		at->start = start;
+		at->count = 0;
+		at->alive = m & ~at->ends;
+		at->complete = m & at->ends;
+		return(1);
+	}
+	ob.type = type;
+	ob.start = start;
+	ob.len = len;
+	ob.count = 0;
+	if(level == 0)q->record = ob;
+	return((m & at->ends) ? JSON_query_match(q, m & at->ends, &ob) : 1);
+}
+
+/* whether ptr holds the text of needle */
+static int JSON_query_find(uint8_t *ptr, size_t len, uint8_t *needle, size_t n){
+	uint8_t *p, *end;
+	if(len < n)return(0);
+	end = ptr + len - n + 2;
+	for(p = ptr + 1; (p < end) && ((p = memchr(p, needle[1], end - p)) != NULL); p++){
+		if((p[-1] == needle[0]) && !memcmp(p, needle + 1, n - 1))return(1);
+	}
+	return(0);
+}
+
+static int JSON_query_run(json_query_t *q, uint8_t *ptr, size_t len){
+	struct JSON_struct jc;
+	struct JSON_query_path *path;
+	int i, ok;
+	q->decided = 0;
+	q->values = 0;
+	q->error = 0;
+	for(i = 0; i < q->predicates; i++){
+		path = &q->path[i];
+		if((path->op != JSON_QUERY_EQ) || (path->literal.type != JSON_TYPE_STRING) || (path->literal.len == 0))continue;
+		if(!JSON_query_find(ptr, len, path->literal.start - 1, path->literal.len + 2))return(0);
+	}
+	JSON_scanner_init(&jc, JSON_query_event, q);
+	ok = (JSON_scan(&jc, ptr, len) == (ssize_t)len) && JSON_scanner_end(&jc, &ptr[len]) && !jc.stop;
+	JSON_stack_free(&jc.stack);
+	return(ok && ((q->decided & q->need) == q->need));
+}
+
+static int JSON_query_write(json_query_t *q, json_writer_t *w){
+	size_t i;
+	int f, found;
+	if(q->n == q->predicates)return(json_write_value(w, &q->record));
+	json_write_begin_array(w);
+	for(f = q->predicates; f < q->n; f++){
+		if((q->wild >> f) & 1)json_write_begin_array(w);
+		for(i = 0, found = 0; i < q->values; i++){
+			if(q->value[i].path != f)continue;
+			json_write_value(w, &q->value[i].value);
+			found = 1;
+		}
+		if((q->wild >> f) & 1){
+			json_write_end_array(w);
+		}else if(!found){
+			json_write_null(w);
+		}
+	}
+	/* writer errors are sticky, the last call reports any of them */
+	return(json_write_end_array(w));
+}
+
+json_query_t *json_query_compile(const char *filter, char **fields, int n){
+/*
+    filter may be NULL or empty to take every record, fields are the paths
+    to project. Returns NULL if a predicate or path does not parse, or if
+    the query has more than 64 paths in all.
+*/
+	json_query_t *q;
+	char *p, *t;
+	size_t size;
+	int i, ok;
+	size = (filter != NULL) ? strlen(filter) + 1 : 1;
+	for(i = 0; i < n; i++)size += strlen(fields[i]) + 1;
+	q = calloc(1, sizeof(json_query_t));
+	if(q == NULL)return(NULL);
+	q->text = malloc(size);
+	q->step = malloc(size * sizeof(struct JSON_query_step));
+	ok = (q->text != NULL) && (q->step != NULL);
+	if(ok){
+		strcpy(q->text, (filter != NULL) ? filter : "");
+		t = q->text;
+		JSON_query_space(&t);
+		if(*t != 0){
+			ok = JSON_query_predicate(q, &t);
+			JSON_query_space(&t);
+			while(ok && (t[0] == '&') && (t[1] == '&')){
+				t += 2;
+				ok = JSON_query_predicate(q, &t);
+				JSON_query_space(&t);
+			}
+			ok = ok && (*t == 0);
+		}
+	}
+	q->predicates = q->n;
+	p = ok ? q->text + strlen(q->text) + 1 : NULL;
+	for(i = 0; ok && (i < n); i++){
+		strcpy(p, fields[i]);
+		t = p;
+		ok = JSON_query_path(q, &t);
+		JSON_query_space(&t);
+		ok = ok && (*t == 0);
+		p += strlen(p) + 1;
+	}
+	if(ok){
+		q->level = calloc(q->depth + 1, sizeof(struct JSON_query_level));
+		ok = (q->level != NULL);
+	}
+	if(!ok){
+		json_query_free(q);
+		return(NULL);
+	}
+	for(i = 0; i < q->n; i++)q->level[q->path[i].steps].ends |= (uint64_t)1 << i;
+	q->all = (q->n == 64) ? ~(uint64_t)0 : ((uint64_t)1 << q->n) - 1;
+	q->need = (q->predicates == 64) ? ~(uint64_t)0 : ((uint64_t)1 << q->predicates) - 1;
+	return(q);
+}
+
+void json_query_free(json_query_t *q){
+	free(q->text);
+	free(q->step);
+	free(q->level);
+	free(q->value);
+	free(q);
+}
+
+int json_query_record(json_query_t *q, uint8_t *ptr, size_t len, json_object_t *values){
+/*
+    Runs one record. Returns 1 if it is valid and matches, and then sets
+    values[i] to the first value of field i, or to type JSON_TYPE_ERROR if
+    the record has none. values may be NULL.
+*/
+	size_t i;
+	int f;
+	if(!JSON_query_run(q, ptr, len))return(0);
+	if(values == NULL)return(1);
+	memset(values, 0, (q->n - q->predicates) * sizeof(json_object_t));
+	for(i = 0; i < q->values; i++){
+		f = q->value[i].path - q->predicates;
+		if(values[f].type == JSON_TYPE_ERROR)values[f] = q->value[i].value;
+	}
+	return(1);
+}
+
+ssize_t json_query_ndjson(json_query_t *q, uint8_t *ptr, size_t len, json_writer_t *w){
+/*
+    Writes every line that matches to w: the record itself if the query has
+    no fields, else an array of the projected values, with null for a field
+    the record lacks and an array of all the values of a field with a
+    wildcard. Returns the number of records written, or -1 if the writer
+    failed or memory ran out.
+*/
+	size_t p, n, i;
+	ssize_t count;
+	count = 0;
+	for(p = 0; p < len; p += n + 1){
+		n = JSON_newline_scan(&ptr[p], len - p);
+		for(i = 0; (i < n) && (ptr[p + i] <= ' '); i++);
+		if(i == n)continue;
+		if(JSON_query_run(q, &ptr[p], n)){
+			if(!JSON_query_write(q, w))return(-1);
+			count++;
+		}else if(q->error){
+			return(-1);
+		}
+	}
+	return(count);
+}
+
+/*
+    Parallel validation of one large document. The buffer is cut into one
+    range per thread and every range is run through the state machine at
+    the same time. A range cannot know the state it starts in, so it starts
+    at its first comma outside of a string, where the state is known up to
+    the modes of the enclosing levels. Whether a byte is inside a string is
+    found from the parity of the unescaped quotes before the range. Levels
+    the range closes or extends before it opened them are guessed and noted,
+    a comma guesses object when a key and a colon follow it. The ranges are
+    then stitched in order, checking the state and every guessed mode
+    against the real stack at the joint. Valid input never fails a check;
+    on the first failure the rest of the text is run serially from the real
+    state, so the result is always the one json_check gives.
+*/
+
+#ifndef JSON_CHUNK_MIN
+#define JSON_CHUNK_MIN (1 << 20)
+#endif
+
+#define JSON_IN_STRING(state) (((state) >= ST) && ((state) <= U4))
+
+struct JSON_chunk{
+	uint8_t *ptr;
+	size_t len;
+	size_t from;		/* the range [from, to) handed to this chunk */
+	size_t to;
+	int quotes;		/* parity of the unescaped quotes in the range */
+	int string;		/* the range begins inside a string */
+	size_t start;		/* the state machine runs over [start, end) */
+	size_t end;		/* start == to marks a range without a comma */
+	int speculative;
+	int base;
+	int ok;
+	int state;
+	ssize_t top;
+	struct JSON_stack stack;
+	int need;		/* levels taken from below the start */
+	int need_mode[JSON_STACK_LEN];
+	size_t commas[JSON_STACK_LEN];
+};
+
+static size_t JSON_chunk_escaped(struct JSON_chunk *ch){
+/*
+    A range that starts after an odd run of backslashes starts escaped.
+*/
+	size_t n;
+	for(n = 0; (n < ch->from) && (ch->ptr[ch->from - n - 1] == '\\'); n++);
+	return((n & 1) ? ch->from : SIZE_MAX);
+}
+
+static void *JSON_chunk_quotes(void *arg){
+	struct JSON_chunk *ch;
+	struct JSON_blocks b;
+	size_t i, e;
+	ch = (struct JSON_chunk *)arg;
+	JSON_blocks_init(&b, ch->ptr, ch->to);
+	e = JSON_chunk_escaped(ch);
+	ch->quotes = 0;
+	for(i = JSON_skip_blocks(&b, S_STRING, ch->from); i < ch->to; i = JSON_skip_blocks(&b, S_STRING, i + 1)){
+		if(i == e)continue;
+		if(ch->ptr[i] == '\\'){
+			e = i + 1;
+		}else if(ch->ptr[i] == '\"'){
+			ch->quotes ^= 1;
+		}
+	}
+	return(NULL);
+}
+
+static int JSON_chunk_guess(uint8_t *ptr, size_t len, size_t i){
+/*
+    The mode of an unseen level at the comma ptr[i].
+*/
+	for(i++; (i < len) && ((ptr[i] == ' ') || (ptr[i] == '\t') || (ptr[i] == '\n') || (ptr[i] == '\r')); i++);
+	if((i >= len) || (ptr[i] != '\"'))return(MODE_ARRAY);
+	for(i++; (i < len) && (ptr[i] != '\"'); i++){
+		if(ptr[i] == '\\')i++;
+	}
+	for(i++; (i < len) && ((ptr[i] == ' ') || (ptr[i] == '\t') || (ptr[i] == '\n') || (ptr[i] == '\r')); i++);
+	return(((i < len) && (ptr[i] == ':')) ? MODE_OBJECT : MODE_ARRAY);
+}
+
+static int JSON_chunk_mode(struct JSON_chunk *ch, int guess){
+	if(ch->top < 0){
+		if(!ch->speculative || (ch->need >= JSON_STACK_LEN))return(-1);
+		ch->need_mode[ch->need++] = guess;
+		JSON_stack_set(&ch->stack, ++ch->top, guess);
+	}
+	return(JSON_stack_get(&ch->stack, ch->top));
+}
+
+static int JSON_chunk_push(struct JSON_chunk *ch, int mode){
+	if(!JSON_stack_set(&ch->stack, ch->top + 1, mode))return(0);
+	ch->top++;
+	return(1);
+}
+
+static int JSON_chunk_pop(struct JSON_chunk *ch, int mode){
+	if(JSON_chunk_mode(ch, mode) != mode)return(0);
+	ch->top--;
+	return(1);
+}
+
+static void JSON_chunk_run(struct JSON_chunk *ch, size_t stop){
+/*
+    Run the state machine from ch->start to the first comma outside of a
+    string at or after stop, or to the end of the text.
+*/
+	struct JSON_blocks b;
+	uint8_t *ptr;
+	size_t i;
+	int c, r, next_state, mode;
+	ptr = ch->ptr;
+	JSON_blocks_init(&b, ptr, ch->len);
+	ch->ok = 0;
+	for(i = JSON_skip(&b, ch->state, ch->start); i < ch->len; i = JSON_skip(&b, ch->state, i + 1)){
+		c = (ptr[i] >= 128) ? C_ETC : ascii_class[ptr[i]];
+		if(c <= ___)return;
+		if((c == C_COMMA) && (i >= stop) && !JSON_IN_STRING(ch->state))break;
+		next_state = state_transition_table[ch->state][c];
+		if(next_state >= 0){
+			ch->state = next_state;
+			continue;
+		}
+		switch(next_state){
+		case -9:
+			if(!JSON_chunk_pop(ch, MODE_KEY))return;
+			ch->state = OK;
+			break;
+		case -8:
+			if(!JSON_chunk_pop(ch, MODE_OBJECT))return;
+			ch->state = OK;
+			break;
+		case -7:
+			if(!JSON_chunk_pop(ch, MODE_ARRAY))return;
+			ch->state = OK;
+			break;
+		case -6:
+			if(!JSON_chunk_push(ch, MODE_KEY))return;
+			ch->state = OB;
+			break;
+		case -5:
+			if(!JSON_chunk_push(ch, MODE_ARRAY))return;
+			ch->state = AR;
+			break;
+		case -4:
+			mode = JSON_chunk_mode(ch, MODE_ARRAY);
+			if(mode == MODE_KEY){
+				ch->state = CO;
+			}else if(mode >= 0){
+				ch->state = OK;
+			}else{
+				return;
+			}
+			break;
+		case -3:
+			mode = (ch->top < 0) ? JSON_chunk_mode(ch, JSON_chunk_guess(ptr, ch->len, i)) : JSON_stack_get(&ch->stack, ch->top);
+			if(mode == MODE_OBJECT){
+				JSON_stack_set(&ch->stack, ch->top, MODE_KEY);
+				ch->state = KE;
+			}else if(mode == MODE_ARRAY){
+				ch->state = VA;
+			}else{
+				return;
+			}
+			r = ch->need + ch->base - (ch->top + 1);
+			if((r >= 0) && (r < JSON_STACK_LEN))ch->commas[r]++;
+			break;
+		case -2:
+			if(!JSON_chunk_pop(ch, MODE_KEY) || !JSON_chunk_push(ch, MODE_OBJECT))return;
+			ch->state = VA;
+			break;
+		default:
+			return;
+		}
+	}
+	ch->end = i < ch->len ? i : ch->len;
+	ch->ok = 1;
+}
+
+static void *JSON_chunk_worker(void *arg){
+	struct JSON_chunk *ch;
+	size_t i, e;
+	int s;
+	ch = (struct JSON_chunk *)arg;
+	if(!ch->speculative){
+		JSON_chunk_run(ch, ch->to);
+		return(NULL);
+	}
+	e = JSON_chunk_escaped(ch);
+	s = ch->string;
+	for(i = ch->from; i < ch->to; i++){
+		if(i == e)continue;
+		if(ch->ptr[i] == '\\'){
+			e = i + 1;
+		}else if(ch->ptr[i] == '\"'){
+			s ^= 1;
+		}else if((ch->ptr[i] == ',') && !s){
+			break;
+		}
 	}
-	if(jc.state >= 0){
-		next_state = state_transition_table[jc.state][C_END];
-		if((jc.state != OK) && (next_state == OK)){
-	    		JSON_set_type(jc.state, jc.start, &ptr[len - 1], &jc.len, &jc.type);
-		}
-		jc.state = next_state;
+	ch->start = i;
+	if(i < ch->to)JSON_chunk_run(ch, ch->to);
+	return(NULL);
+}
+
+static void JSON_chunk_spawn(struct JSON_chunk *chunk, pthread_t *tid, int n, void *(*fn)(void *)){
+/*
+    Run fn on every chunk, chunk 0 on the calling thread. Chunks that get
+    no thread of their own run there too.
+*/
+	int k, started;
+	for(started = 1; started < n; started++){
+		if(pthread_create(&tid[started], NULL, fn, &chunk[started]))break;
 	}
-	if((jc.state == OK) && pop(&jc, MODE_DONE) && (jc.type != JSON_TYPE_ERROR)){
-		object->type = jc.type;
-		object->start = jc.start;
-		object->len = jc.len;
-		object->count = jc.count;
-		return(1);
+	for(k = started; k < n; k++){
+		fn(&chunk[k]);
+	}
+	fn(&chunk[0]);
+	for(k = 1; k < started; k++){
+		pthread_join(tid[k], NULL);
 	}
-	return(0);
 }
 
-int json_get(uint8_t *ptr, int len, int index, json_object_t *key, json_object_t *value){
-	struct JSON_struct jc;
-	int i;
-	jc.state = GO;
-	jc.top = -1;
-	jc.type = JSON_TYPE_ERROR;
-	jc.count = 0;
-	jc.key_start = NULL;
-	push(&jc, MODE_DONE);
-	for(i = 0; i < len; i++){
-		if(!JSON_checker_char(&jc, &ptr[i])){
-			jc.state = ___;
-			break;
-		}
-		if((jc.value_type != JSON_TYPE_ERROR) && jc.count && ((jc.count - 1) == index)){
-			if(key != NULL){
-				if(jc.key_start == NULL){
-					key->type = JSON_TYPE_INDEX;
-					key->start = NULL;
-					key->len = 0;
-					key->count = index;
-				}else{
-					key->type = JSON_TYPE_STRING;
-					key->start = jc.key_start;
-					key->len = jc.key_len;
-					key->count = 0;
-				}
-			}
-			value->type = jc.value_type;
-			value->start = jc.value_start;
-			value->len = jc.value_len;
-			value->count = jc.value_count;
-			return(1);
+static int JSON_chunk_join(struct JSON_chunk *real, struct JSON_chunk *ch, size_t *count){
+/*
+    Append the speculative run ch to real if every guess it made holds.
+*/
+	ssize_t k, h;
+	h = real->top + 1;
+	if(!ch->ok || (real->end != ch->start))return(0);
+	if(state_transition_table[real->state][C_COMMA] != -3)return(0);
+	if(ch->need > h)return(0);
+	for(k = 0; k < ch->need; k++){
+		if(JSON_stack_get(&real->stack, real->top - k) != ch->need_mode[k])return(0);
+	}
+	if((h >= 2) && ((h - 2) < JSON_STACK_LEN))*count += ch->commas[h - 2];
+	real->top -= ch->need;
+	for(k = 0; k <= ch->top; k++){
+		if(!JSON_stack_set(&real->stack, ++real->top, JSON_stack_get(&ch->stack, k))){
+			real->ok = 0;
+			return(0);
 		}
 	}
-	return(0);
+	real->state = ch->state;
+	real->end = ch->end;
+	return(1);
 }
 
-int json_get_value(uint8_t *ptr, int len, char *key, json_object_t *value){
-	json_object_t table, _key;
-	int i;
-	if(!json_check(ptr, len, &table))return(0);
-	if(table.type != JSON_TYPE_MAP)return(0);
-	if(table.count < 1)return(0);
-	for(i = 0; i < table.count; i++){
-		if(!json_get(ptr, len, i, &_key, value))return(0);
-		if(json_isequal(&_key, key))return(1);
+int json_check_parallel(uint8_t *ptr, size_t len, int threads, json_object_t *object){
+/*
+    json_check on up to threads threads, 0 for one per CPU. Small texts
+    and texts that are not an object or an array are checked serially.
+*/
+	struct JSON_chunk *chunk, *real;
+	pthread_t *tid;
+	size_t i, first, last, count;
+	int k, n, string, ok;
+	n = threads > 0 ? threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if((size_t)n > (len / JSON_CHUNK_MIN))n = len / JSON_CHUNK_MIN;
+	for(first = 0; (first < len) && ((ptr[first] == ' ') || (ptr[first] == '\t') || (ptr[first] == '\n') || (ptr[first] == '\r')); first++);
+	if((n < 2) || (first == len) || ((ptr[first] != '{') && (ptr[first] != '[')))return(json_check(ptr, len, object));
+	chunk = calloc(n, sizeof(struct JSON_chunk));
+	tid = calloc(n, sizeof(pthread_t));
+	if((chunk == NULL) || (tid == NULL)){
+		free(chunk);
+		free(tid);
+		return(json_check(ptr, len, object));
+	}
+	for(k = 0; k < n; k++){
+		chunk[k].ptr = ptr;
+		chunk[k].len = len;
+		chunk[k].from = (len / n) * k;
+		chunk[k].to = (k == (n - 1)) ? len : (len / n) * (k + 1);
+	}
+	JSON_chunk_spawn(chunk, tid, n, JSON_chunk_quotes);
+	string = 0;
+	for(k = 0; k < n; k++){
+		chunk[k].string = string;
+		string ^= chunk[k].quotes;
+		chunk[k].speculative = k > 0;
+		chunk[k].base = k > 0 ? 0 : 2;
+		chunk[k].state = k > 0 ? OK : GO;
+		chunk[k].top = -1;
+	}
+	JSON_stack_set(&chunk[0].stack, ++chunk[0].top, MODE_DONE);
+	JSON_chunk_spawn(chunk, tid, n, JSON_chunk_worker);
+	real = &chunk[0];
+	count = real->commas[0];
+	for(k = 1; real->ok && (k < n) && (real->end < len); k++){
+		if(chunk[k].start == chunk[k].to)continue;
+		if(!JSON_chunk_join(real, &chunk[k], &count))break;
+	}
+	ok = real->ok;
+	if(ok && (real->end < len)){
+		real->start = real->end;
+		memset(real->commas, 0, sizeof(real->commas));
+		JSON_chunk_run(real, len);
+		count += real->commas[0];
+		ok = real->ok;
+	}
+	ok = ok && (state_transition_table[real->state][C_END] == OK) && (real->top == 0) && (JSON_stack_get(&real->stack, 0) == MODE_DONE);
+	if(ok){
+		for(last = len - 1; (ptr[last] == ' ') || (ptr[last] == '\t') || (ptr[last] == '\n') || (ptr[last] == '\r'); last--);
+		for(i = first + 1; (ptr[i] == ' ') || (ptr[i] == '\t') || (ptr[i] == '\n') || (ptr[i] == '\r'); i++);
+		object->type = (ptr[first] == '{') ? JSON_TYPE_MAP : JSON_TYPE_ARRAY;
+		object->start = &ptr[first];
+		object->len = last - first + 1;
+		object->count = (i == last) ? 0 : count + 1;
+	}
+	for(k = 0; k < n; k++){
+		JSON_stack_free(&chunk[k].stack);
 	}
+	free(chunk);
+	free(tid);
+	return(ok);
+}
+
+/*
+    Writer. Output is appended straight into one buffer: a fixed caller
+    buffer, a buffer owned by the writer that grows, or either of them used
+    as a chunk that is flushed to a file descriptor when it fills up. The
+    per level stack remembers whether the level is an object, whether it
+    already has members and whether a key waits for its value, so commas
+    and colons are inserted automatically. Values written at the top level
+    are separated by newlines.
+*/
+
+#define W_OBJECT 1
+#define W_MORE   2
+#define W_KEY    4
+
+static int JSON_writer_fail(json_writer_t *w){
+	w->error = 1;
 	return(0);
 }
 
-int json_isequal(json_object_t *jstr, char *str){
-	int l;
-	if(jstr->type != JSON_TYPE_STRING)return(0);
-	l = strlen(str);
-	if(jstr->len != (l + 2))return(0);
-	return(!memcmp(jstr->start + 1, str, l));
+static int JSON_writer_reserve(json_writer_t *w, size_t n){
+	char *buf;
+	size_t size;
+	if(w->error)return(0);
+	if((w->len + n) <= w->size)return(1);
+	if(w->fd >= 0){
+		if(!json_writer_flush(w))return(0);
+		if(n <= w->size)return(1);
+	}else if(w->owned){
+		size = w->size ? w->size : 4096;
+		while(size < (w->len + n))size *= 2;
+		buf = realloc(w->buf, size);
+		if(buf == NULL)return(JSON_writer_fail(w));
+		w->buf = buf;
+		w->size = size;
+		return(1);
+	}
+	return(JSON_writer_fail(w));
 }
 
-int json_value_isequal(uint8_t *ptr, int len, char *key, char *value){
-	json_object_t table, _key, _value;
-	int i;
-	if(!json_check(ptr, len, &table))return(0);
-	if(table.type != JSON_TYPE_MAP)return(0);
-	if(table.count < 1)return(0);
-	for(i = 0; i < table.count; i++){
-		if(!json_get(ptr, len, i, &_key, &_value))return(0);
-		if(json_isequal(&_key, key)){
-			if(json_isequal(&_value, value))return(1);
-			return(0);
+static int JSON_writer_write(json_writer_t *w, const char *ptr, size_t len){
+	ssize_t n;
+	while(len){
+		n = write(w->fd, ptr, len);
+		if(n < 0){
+			if(errno == EINTR)continue;
+			return(JSON_writer_fail(w));
 		}
+		ptr += n;
+		len -= n;
 	}
-	return(0);
+	return(1);
 }
 
-long long int json_int(json_object_t *ob){
-	int l;
-	char buffer[32];
-	if(ob->type == JSON_TYPE_STRING){
-		if(ob->len < 2)return(0);
-		l = ob->len > 33 ? 31 : ob->len - 2;
-		memcpy(&buffer[0], &ob->start[1], l);
-	}else{
-		if(!ob->len)return(0);
-		l = ob->len > 31 ? 31 : ob->len;
-		memcpy(&buffer[0], &ob->start[0], l);
+static int JSON_writer_put(json_writer_t *w, const char *ptr, size_t len){
+	if((w->fd >= 0) && (len > w->size)){
+		return(json_writer_flush(w) && JSON_writer_write(w, ptr, len));
 	}
-	buffer[l] = 0;
-	return(strtoll(&buffer[0], NULL, 10));
+	if(!JSON_writer_reserve(w, len))return(0);
+	memcpy(&w->buf[w->len], ptr, len);
+	w->len += len;
+	return(1);
 }
 
-double json_double(json_object_t *ob){
-	int l;
-	char buffer[32];
-	if(ob->type == JSON_TYPE_STRING){
-		if(ob->len < 2)return(0);
-		l = ob->len > 33 ? 31 : ob->len - 2;
-		memcpy(&buffer[0], &ob->start[1], l);
+static int JSON_writer_escaped(json_writer_t *w, const char *str, size_t len){
+	size_t n, e;
+	while(len){
+		n = len;
+		if((w->fd >= 0) && (n > (w->size / 6)))n = w->size > 6 ? w->size / 6 : 1;
+		e = json_escape(NULL, str, n);
+		if(!JSON_writer_reserve(w, e))return(0);
+		w->len += json_escape(&w->buf[w->len], str, n);
+		str += n;
+		len -= n;
+	}
+	return(1);
+}
+
+/* separator and bookkeeping before any value */
+static int JSON_writer_value(json_writer_t *w){
+	uint8_t *level;
+	if(w->error)return(0);
+	level = &w->stack[w->top];
+	if(*level & W_OBJECT){
+		if(!(*level & W_KEY))return(JSON_writer_fail(w));
+		*level &= ~W_KEY;
+		return(1);
+	}
+	if(*level & W_MORE){
+		if(!JSON_writer_put(w, w->top ? "," : "\n", 1))return(0);
+	}
+	*level |= W_MORE;
+	return(1);
+}
+
+static int JSON_writer_begin(json_writer_t *w, char c, int object){
+	if(w->top >= (JSON_WRITER_DEPTH - 1))return(JSON_writer_fail(w));
+	if(!JSON_writer_value(w) || !JSON_writer_put(w, &c, 1))return(0);
+	w->stack[++w->top] = object ? W_OBJECT : 0;
+	return(1);
+}
+
+static int JSON_writer_end(json_writer_t *w, char c, int object){
+	if(w->error)return(0);
+	if((w->top == 0) || ((w->stack[w->top] & W_OBJECT) != object) || (w->stack[w->top] & W_KEY)){
+		return(JSON_writer_fail(w));
+	}
+	w->top--;
+	return(JSON_writer_put(w, &c, 1));
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t size, int fd){
+/*
+    With buf NULL the writer allocates its own buffer of size bytes (4096
+    if 0), which grows as needed unless fd is given. With fd >= 0 the
+    buffer is written to fd whenever it fills up and by json_writer_flush.
+*/
+	memset(w, 0, sizeof(json_writer_t));
+	w->fd = fd;
+	if(buf == NULL){
+		w->owned = 1;
+		w->size = size ? size : 4096;
+		w->buf = malloc(w->size);
+		if(w->buf == NULL){
+			w->size = 0;
+			if(fd >= 0)w->error = 1;
+		}
 	}else{
-		if(!ob->len)return(0);
-		l = ob->len > 31 ? 31 : ob->len;
-		memcpy(&buffer[0], &ob->start[0], l);
+		w->buf = buf;
+		w->size = size;
 	}
-	buffer[l] = 0;
-	return(strtod(&buffer[0], NULL));
+}
+
+int json_writer_flush(json_writer_t *w){
+	if(w->error)return(0);
+	if(w->fd < 0)return(1);
+	if(!JSON_writer_write(w, w->buf, w->len))return(0);
+	w->len = 0;
+	return(1);
+}
+
+void json_writer_free(json_writer_t *w){
+	if(w->owned)free(w->buf);
+	w->buf = NULL;
+	w->size = w->len = 0;
+}
+
+int json_write_begin_object(json_writer_t *w){
+	return(JSON_writer_begin(w, '{', W_OBJECT));
+}
+
+int json_write_end_object(json_writer_t *w){
+	return(JSON_writer_end(w, '}', W_OBJECT));
+}
+
+int json_write_begin_array(json_writer_t *w){
+	return(JSON_writer_begin(w, '[', 0));
+}
+
+int json_write_end_array(json_writer_t *w){
+	return(JSON_writer_end(w, ']', 0));
+}
+
+int json_write_key(json_writer_t *w, const char *key, size_t len){
+	uint8_t *level;
+	if(w->error)return(0);
+	level = &w->stack[w->top];
+	if(!(*level & W_OBJECT) || (*level & W_KEY))return(JSON_writer_fail(w));
+	if((*level & W_MORE) && !JSON_writer_put(w, ",", 1))return(0);
+	*level |= W_MORE | W_KEY;
+	return(JSON_writer_put(w, "\"", 1) && JSON_writer_escaped(w, key, len) && JSON_writer_put(w, "\":", 2));
+}
+
+int json_write_string(json_writer_t *w, const char *str, size_t len){
+	return(JSON_writer_value(w) && JSON_writer_put(w, "\"", 1) && JSON_writer_escaped(w, str, len) && JSON_writer_put(w, "\"", 1));
+}
+
+int json_write_int(json_writer_t *w, long long int value){
+	char num[24];
+	int n;
+	n = json_itoa(value, num);
+	return(JSON_writer_value(w) && JSON_writer_put(w, num, n));
+}
+
+int json_write_double(json_writer_t *w, double value){
+	char num[32];
+	int n;
+	n = json_dtoa(value, num);
+	if(!n)return(JSON_writer_fail(w));
+	return(JSON_writer_value(w) && JSON_writer_put(w, num, n));
+}
+
+int json_write_bool(json_writer_t *w, int value){
+	return(JSON_writer_value(w) && (value ? JSON_writer_put(w, "true", 4) : JSON_writer_put(w, "false", 5)));
+}
+
+int json_write_null(json_writer_t *w){
+	return(JSON_writer_value(w) && JSON_writer_put(w, "null", 4));
+}
+
+int json_write_value(json_writer_t *w, json_object_t *value){
+/*
+    Copy a value found by the parser, e.g. with json_get, as it is.
+*/
+	if((value->type == JSON_TYPE_ERROR) || (value->len == 0))return(JSON_writer_fail(w));
+	return(JSON_writer_value(w) && JSON_writer_put(w, (char *)value->start, value->len));
 }
 
 #ifdef MAIN_CONTROLLER 
-static NSString *JSON_string(uint8_t *ptr, int len){
+static NSString *JSON_string(uint8_t *ptr, size_t len){
 	json_utf8_t c;
 	int i;
 	NSMutableString *str;
@@ -410,7 +5009,7 @@ static NSString *JSON_string(uint8_t *ptr, int len){
 	return(str);
 }
 
-static NSNumber *JSON_number(uint8_t *ptr, int len, int type){
+static NSNumber *JSON_number(uint8_t *ptr, size_t len, int type){
 	char numbuf[128];
 	if(len > 126)len = 126;
 	memcpy(&numbuf[0], ptr, len);
@@ -423,22 +5022,25 @@ static NSNumber *JSON_number(uint8_t *ptr, int len, int type){
 	return([NSNumber numberWithInt: 0]);
 }
 
-static id JSON_unserialize_object(uint8_t *ptr, int len){
+static id JSON_unserialize_object(uint8_t *ptr, size_t len){
 	BOOL next;
 	struct JSON_struct jc;
 	id table, t;
-	int i, next_state;
+	size_t i;
+	int next_state, ok;
 	jc.state = GO;
 	jc.top = -1;
 	jc.type = JSON_TYPE_ERROR;
 	jc.count = 0;
 	jc.key_start = NULL;
+	JSON_stack_init(&jc.stack);
 	table = nil;
 	next = NO;
 	push(&jc, MODE_DONE);
 	for(i = 0; i < len; i++){
 		if(!JSON_checker_char(&jc, &ptr[i])){
 			jc.state = ___;
+			JSON_stack_free(&jc.stack);
 			return(nil);
 		}
 		if((jc.value_type != JSON_TYPE_ERROR) && !next && jc.count){
@@ -479,7 +5081,9 @@ static id JSON_unserialize_object(uint8_t *ptr, int len){
 		}
 		jc.state = next_state;
 	}
-	if((jc.state == OK) && pop(&jc, MODE_DONE) && (jc.type != JSON_TYPE_ERROR)){
+	ok = (jc.state == OK) && pop(&jc, MODE_DONE) && (jc.type != JSON_TYPE_ERROR);
+	JSON_stack_free(&jc.stack);
+	if(ok){
 		if(table != nil)return(table);
 		if(jc.type == JSON_TYPE_NULL){
 			return([NSNull null]);
@@ -502,7 +5106,7 @@ static id JSON_unserialize_object(uint8_t *ptr, int len){
 	return(nil);
 }
 
-id json_unserialize(const void *str, int len){
+id json_unserialize(const void *str, size_t len){
 	json_object_t ob;
 	if(!json_check((uint8_t *)str, len, &ob))return(nil);
 	return(JSON_unserialize_object((uint8_t *)str, len));
@@ -618,7 +5222,7 @@ NSData *data_serialize(id data){
 @end
 #endif
 
-static void JSON_set_type(int state, uint8_t *start, uint8_t *end, int *len, int *type){
+static void JSON_set_type(int state, uint8_t *start, uint8_t *end, size_t *len, int *type){
 	*len = ((end - start) + 1);
 	if(state == N3){
 		*type = JSON_TYPE_NULL;
@@ -699,8 +5303,8 @@ static int JSON_checker_char(struct JSON_struct *jc, uint8_t *next_char){
     }
     if((jc->state != OK) && (next_state == OK)){
 	    JSON_set_type(jc->state, jc->start, next_char, &jc->len, &jc->type);
-	    if(((jc->type == JSON_TYPE_INT) || (jc->type == JSON_TYPE_DOUBLE)) && jc->value_len)jc->len--;
-            if((jc->top == 1) && ((jc->stack[jc->top] == MODE_ARRAY) || (jc->stack[jc->top] == MODE_OBJECT))){
+	    if((jc->type == JSON_TYPE_INT) || (jc->type == JSON_TYPE_DOUBLE))jc->len--;
+            if((jc->top == 1) && ((JSON_stack_get(&jc->stack, 1) == MODE_ARRAY) || (JSON_stack_get(&jc->stack, 1) == MODE_OBJECT))){
 		JSON_set_type(jc->state, jc->value_start, next_char, &jc->value_len, &jc->value_type);
 		if(((jc->value_type == JSON_TYPE_INT) || (jc->value_type == JSON_TYPE_DOUBLE)) && jc->value_len)jc->value_len--;
 //		printf("AAA: %d\n", jc->top);
@@ -800,7 +5404,7 @@ static int JSON_checker_char(struct JSON_struct *jc, uint8_t *next_char){
             break;
 
 /* " */ case -4:
-            switch (jc->stack[jc->top]) {
+            switch (JSON_stack_get(&jc->stack, jc->top)) {
             case MODE_KEY:
 	    	if(jc->top == 1){
 			JSON_set_type(jc->state, jc->key_start, next_char, &jc->key_len, &jc->value_type);
@@ -827,7 +5431,7 @@ static int JSON_checker_char(struct JSON_struct *jc, uint8_t *next_char){
             break;
 
 /* , */ case -3:
-            switch (jc->stack[jc->top]) {
+            switch (JSON_stack_get(&jc->stack, jc->top)) {
             case MODE_OBJECT:
 /*
     A comma causes a flip from object mode to key mode.
@@ -882,7 +5486,302 @@ static int JSON_checker_char(struct JSON_struct *jc, uint8_t *next_char){
     return(1);
 }
 
-int json_decode_string(const char *ptr, int len, json_utf8_t *utf8_char){
+static void JSON_scanner_init(struct JSON_struct *jc, int (*event)(struct JSON_struct *, int, int, uint8_t *, size_t), void *ctx){
+	jc->state = GO;
+	jc->top = -1;
+	JSON_stack_init(&jc->stack);
+	jc->stop = 0;
+	jc->start = NULL;
+	jc->event = event;
+	jc->ctx = ctx;
+	push(jc, MODE_DONE);
+}
+
+static void JSON_scanner_value(struct JSON_struct *jc, uint8_t *end){
+	size_t len;
+	int type;
+	JSON_set_type(jc->state, jc->start, end, &len, &type);
+	if(!jc->event(jc, JSON_EVENT_VALUE, type, jc->start, len))jc->stop = 1;
+}
+
+static int JSON_scanner_char(struct JSON_struct *jc, uint8_t *next_char){
+/*
+    Same transitions as JSON_checker_char, but every key and value is reported
+    through jc->event at the byte that completes it, whatever its depth.
+    Bytes that keep the state unchanged (string bodies, digits, whitespace)
+    need no bookkeeping at all.
+*/
+	int next_class, next_state;
+	if(*next_char >= 128){
+		next_class = C_ETC;
+	}else{
+		next_class = ascii_class[*next_char];
+		if(next_class <= ___)return(0);
+	}
+	next_state = state_transition_table[jc->state][next_class];
+	if(next_state == jc->state)return(1);
+	if(next_state == ___)return(0);
+	if(next_state >= 0){
+		if((jc->state == GO) || (jc->state == VA) || (jc->state == AR) || (jc->state == OB) || (jc->state == KE)){
+			jc->start = next_char;
+		}else if(next_state == OK){
+			JSON_scanner_value(jc, JSON_IS_NUMBER(jc->state) ? next_char - 1 : next_char);
+		}
+		jc->state = next_state;
+		return(1);
+	}
+	switch(next_state){
+/* empty } */
+	case -9:
+		if(!pop(jc, MODE_KEY))return(0);
+		if(!jc->event(jc, JSON_EVENT_END, JSON_TYPE_MAP, next_char, 1))jc->stop = 1;
+		jc->state = OK;
+		break;
+/* } */	case -8:
+		if(JSON_IS_NUMBER(jc->state))JSON_scanner_value(jc, next_char - 1);
+		if(!pop(jc, MODE_OBJECT))return(0);
+		if(!jc->event(jc, JSON_EVENT_END, JSON_TYPE_MAP, next_char, 1))jc->stop = 1;
+		jc->state = OK;
+		break;
+/* ] */	case -7:
+		if(JSON_IS_NUMBER(jc->state))JSON_scanner_value(jc, next_char - 1);
+		if(!pop(jc, MODE_ARRAY))return(0);
+		if(!jc->event(jc, JSON_EVENT_END, JSON_TYPE_ARRAY, next_char, 1))jc->stop = 1;
+		jc->state = OK;
+		break;
+/* { */	case -6:
+		if(!jc->event(jc, JSON_EVENT_BEGIN, JSON_TYPE_MAP, next_char, 1))jc->stop = 1;
+		if(!push(jc, MODE_KEY))return(0);
+		jc->state = OB;
+		break;
+/* [ */	case -5:
+		if(!jc->event(jc, JSON_EVENT_BEGIN, JSON_TYPE_ARRAY, next_char, 1))jc->stop = 1;
+		if(!push(jc, MODE_ARRAY))return(0);
+		jc->state = AR;
+		break;
+/* " */	case -4:
+		if(JSON_stack_get(&jc->stack, jc->top) == MODE_KEY){
+			if(!jc->event(jc, JSON_EVENT_KEY, JSON_TYPE_STRING, jc->start, (next_char - jc->start) + 1))jc->stop = 1;
+			jc->state = CO;
+		}else{
+			if(!jc->event(jc, JSON_EVENT_VALUE, JSON_TYPE_STRING, jc->start, (next_char - jc->start) + 1))jc->stop = 1;
+			jc->state = OK;
+		}
+		break;
+/* , */	case -3:
+		if(JSON_IS_NUMBER(jc->state))JSON_scanner_value(jc, next_char - 1);
+		if(JSON_stack_get(&jc->stack, jc->top) == MODE_OBJECT){
+			if(!pop(jc, MODE_OBJECT) || !push(jc, MODE_KEY))return(0);
+			jc->state = KE;
+		}else if(JSON_stack_get(&jc->stack, jc->top) == MODE_ARRAY){
+			jc->state = VA;
+		}else{
+			return(0);
+		}
+		break;
+/* : */	case -2:
+		if(!pop(jc, MODE_KEY) || !push(jc, MODE_OBJECT))return(0);
+		jc->state = VA;
+		break;
+	default:
+		return(0);
+	}
+	return(1);
+}
+
+static int JSON_scanner_end(struct JSON_struct *jc, uint8_t *end){
+/*
+    Feed the buffer end. A number at the very end of the text is only
+    complete here.
+*/
+	if(JSON_IS_NUMBER(jc->state))JSON_scanner_value(jc, end - 1);
+	if(state_transition_table[jc->state][C_END] != OK)return(0);
+	jc->state = OK;
+	return(pop(jc, MODE_DONE));
+}
+
+static ssize_t JSON_scan(struct JSON_struct *jc, uint8_t *ptr, size_t len){
+/*
+    Run the scanner over len bytes. Returns the number of bytes consumed,
+    which is less than len if the event callback asked to stop, or -1 if
+    the text is rejected.
+*/
+	struct JSON_blocks b;
+	size_t i;
+	JSON_blocks_init(&b, ptr, len);
+	for(i = JSON_skip(&b, jc->state, 0); i < len; i = JSON_skip(&b, jc->state, i + 1)){
+		if(!JSON_scanner_char(jc, &ptr[i])){
+			JSON_STAT_ADD(bytes, i + 1);
+			return(-1);
+		}
+		if(jc->stop){
+			JSON_STAT_ADD(bytes, i + 1);
+			return(i + 1);
+		}
+	}
+	JSON_STAT_ADD(bytes, len);
+	return(len);
+}
+
+/* hex digit values, 0x100 marks a byte that is not a hex digit */
+static const uint16_t JSON_hex[256] = {
+#define X 0x100
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X,
+	X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X
+#undef X
+};
+
+/*
+    Bulk string decoding. Runs without a backslash are copied as they are,
+    16 or 32 bytes at a time, and only the escapes go through the slow path.
+    The run copiers copy at most n bytes and stop at the first backslash,
+    returning the number of bytes copied.
+*/
+
+static size_t JSON_copy_run_scalar(uint8_t *dst, uint8_t *src, size_t n){
+	size_t i;
+	for(i = 0; (i < n) && (src[i] != '\\'); i++){
+		dst[i] = src[i];
+	}
+	return(i);
+}
+
+#ifdef JSON_SIMD_X86
+__attribute__((target("sse2")))
+static size_t JSON_copy_run_sse2(uint8_t *dst, uint8_t *src, size_t n){
+	__m128i v, bs;
+	size_t i;
+	int m;
+	bs = _mm_set1_epi8('\\');
+	for(i = 0; i + 16 <= n; i += 16){
+		v = _mm_loadu_si128((__m128i *)&src[i]);
+		_mm_storeu_si128((__m128i *)&dst[i], v);
+		m = _mm_movemask_epi8(_mm_cmpeq_epi8(v, bs));
+		if(m)return(i + __builtin_ctz(m));
+	}
+	return(i + JSON_copy_run_scalar(&dst[i], &src[i], n - i));
+}
+
+__attribute__((target("avx2")))
+static size_t JSON_copy_run_avx2(uint8_t *dst, uint8_t *src, size_t n){
+	__m256i v, bs;
+	size_t i;
+	uint32_t m;
+	bs = _mm256_set1_epi8('\\');
+	for(i = 0; i + 32 <= n; i += 32){
+		v = _mm256_loadu_si256((__m256i *)&src[i]);
+		_mm256_storeu_si256((__m256i *)&dst[i], v);
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bs));
+		if(m)return(i + __builtin_ctz(m));
+	}
+	return(i + JSON_copy_run_scalar(&dst[i], &src[i], n - i));
+}
+#endif
+
+/* set by JSON_dispatch_init */
+static size_t (*JSON_copy_run)(uint8_t *dst, uint8_t *src, size_t n) = JSON_copy_run_scalar;
+
+static int JSON_hex4(uint8_t *p){
+	int c;
+	c = (JSON_hex[p[0]] << 12) | (JSON_hex[p[1]] << 8) | (JSON_hex[p[2]] << 4) | JSON_hex[p[3]];
+	if((JSON_hex[p[0]] | JSON_hex[p[1]] | JSON_hex[p[2]] | JSON_hex[p[3]]) & 0x100)return(-1);
+	return(c);
+}
+
+static int JSON_utf8_put(uint8_t *dst, json_utf8_t c){
+	if(c < 0x80){
+		dst[0] = c;
+		return(1);
+	}else if(c < 0x800){
+		dst[0] = (c >> 6) | 0xC0;
+		dst[1] = (c & 0x3F) | 0x80;
+		return(2);
+	}else if(c < 0x10000){
+		dst[0] = (c >> 12) | 0xE0;
+		dst[1] = ((c >> 6) & 0x3F) | 0x80;
+		dst[2] = (c & 0x3F) | 0x80;
+		return(3);
+	}
+	dst[0] = (c >> 18) | 0xF0;
+	dst[1] = ((c >> 12) & 0x3F) | 0x80;
+	dst[2] = ((c >> 6) & 0x3F) | 0x80;
+	dst[3] = (c & 0x3F) | 0x80;
+	return(4);
+}
+
+ssize_t json_string_decode(json_object_t *ob, uint8_t *dst, size_t size){
+/*
+    Decode a string value, quotes included, into UTF-8. The result is never
+    longer than ob->len - 2 bytes and is not NUL terminated. Surrogate pairs
+    are joined, lone surrogates become U+FFFD. Returns the decoded length,
+    or -1 on a bad escape or when dst is too small. dst and the value must
+    not overlap.
+*/
+	uint8_t *s, *end, utf8[4];
+	size_t d, n;
+	int c, lo;
+	JSON_STATS_PHASE(JSON_PHASE_STRING);
+	JSON_STAT_ADD(string_decodes, 1);
+	if((ob->type != JSON_TYPE_STRING) || (ob->len < 2) || (ob->start[0] != '\"') || (ob->start[ob->len - 1] != '\"'))return(-1);
+	s = ob->start + 1;
+	end = ob->start + ob->len - 1;
+	d = 0;
+	while(s < end){
+		n = (size_t)(end - s) < (size - d) ? (size_t)(end - s) : (size - d);
+		n = JSON_copy_run(&dst[d], s, n);
+		s += n;
+		d += n;
+		if(s >= end)break;
+		if((*s != '\\') || ((end - s) < 2))return(-1);
+		switch(s[1]){
+		case '\"': c = '\"'; break;
+		case '\\': c = '\\'; break;
+		case '/': c = '/'; break;
+		case 'b': c = '\b'; break;
+		case 'f': c = '\f'; break;
+		case 'n': c = '\n'; break;
+		case 'r': c = '\r'; break;
+		case 't': c = '\t'; break;
+		case 'u':
+			if(((end - s) < 6) || ((c = JSON_hex4(&s[2])) < 0))return(-1);
+			if((c >= 0xD800) && (c < 0xDC00) && ((end - s) >= 12) && (s[6] == '\\') && (s[7] == 'u') &&
+			   ((lo = JSON_hex4(&s[8])) >= 0xDC00) && (lo < 0xE000)){
+				c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+				s += 6;
+			}else if((c >= 0xD800) && (c < 0xE000)){
+				c = 0xFFFD;
+			}
+			s += 4;
+			break;
+		default:
+			return(-1);
+		}
+		s += 2;
+		n = JSON_utf8_put(utf8, c);
+		if((d + n) > size)return(-1);
+		memcpy(&dst[d], utf8, n);
+		d += n;
+	}
+	return((ssize_t)d);
+}
+
+int json_decode_string(const char *ptr, size_t len, json_utf8_t *utf8_char){
+	JSON_STATS_PHASE(JSON_PHASE_STRING);
+	JSON_STAT_ADD(string_decodes, 1);
 	if(!len)return(0);
 	if(ptr[0] == '\\'){
 		if(len > 1){
@@ -935,74 +5834,156 @@ int json_decode_string(const char *ptr, int len, json_utf8_t *utf8_char){
 }
 
 static json_utf8_t hex_to_utf8(uint8_t c){
-	if(c == '1')return(1);
-	if(c == '2')return(2);
-	if(c == '3')return(3);
-	if(c == '4')return(4);
-	if(c == '5')return(5);
-	if(c == '6')return(6);
-	if(c == '7')return(7);
-	if(c == '8')return(8);
-	if(c == '9')return(9);
-	if(c == 'A' || c == 'a')return(10);
-	if(c == 'B' || c == 'b')return(11);
-	if(c == 'C' || c == 'c')return(12);
-	if(c == 'D' || c == 'd')return(13);
-	if(c == 'E' || c == 'e')return(14);
-	if(c == 'F' || c == 'f')return(15);
-	return(0);
+	return(JSON_hex[c] & 0x0F);
+}
+
+/*
+    String escaping. The scanners return the length of the leading run that
+    needs no escaping, looking at 16 or 32 bytes at a time; such runs are
+    copied with memcpy. Quotes, backslashes and all control characters are
+    escaped, every other byte, UTF-8 sequences included, is passed through.
+*/
+
+static size_t JSON_escape_scan_scalar(const uint8_t *p, size_t n){
+	size_t i;
+	for(i = 0; (i < n) && (p[i] >= 0x20) && (p[i] != '\"') && (p[i] != '\\'); i++);
+	return(i);
+}
+
+#ifdef JSON_SIMD_X86
+__attribute__((target("sse2")))
+static size_t JSON_escape_scan_sse2(const uint8_t *p, size_t n){
+	__m128i v, q, bs, ctl;
+	size_t i;
+	int m;
+	q = _mm_set1_epi8('\"');
+	bs = _mm_set1_epi8('\\');
+	ctl = _mm_set1_epi8(0x1F);
+	for(i = 0; i + 16 <= n; i += 16){
+		v = _mm_loadu_si128((__m128i *)&p[i]);
+		m = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, bs)), _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl)));
+		if(m)return(i + __builtin_ctz(m));
+	}
+	return(i + JSON_escape_scan_scalar(&p[i], n - i));
+}
+
+__attribute__((target("avx2")))
+static size_t JSON_escape_scan_avx2(const uint8_t *p, size_t n){
+	__m256i v, q, bs, ctl;
+	size_t i;
+	uint32_t m;
+	q = _mm256_set1_epi8('\"');
+	bs = _mm256_set1_epi8('\\');
+	ctl = _mm256_set1_epi8(0x1F);
+	for(i = 0; i + 32 <= n; i += 32){
+		v = _mm256_loadu_si256((__m256i *)&p[i]);
+		m = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, bs)), _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctl), ctl)));
+		if(m)return(i + __builtin_ctz(m));
+	}
+	return(i + JSON_escape_scan_scalar(&p[i], n - i));
+}
+#endif
+
+/* set by JSON_dispatch_init */
+static size_t (*JSON_escape_scan)(const uint8_t *p, size_t n) = JSON_escape_scan_scalar;
+
+/* write the escape sequence for c to dst if not NULL, return its length */
+static int JSON_escape_char(uint8_t *dst, uint8_t c){
+	static const char hex[] = "0123456789abcdef";
+	int e;
+	switch(c){
+	case '\"': e = '\"'; break;
+	case '\\': e = '\\'; break;
+	case '\b': e = 'b'; break;
+	case '\f': e = 'f'; break;
+	case '\n': e = 'n'; break;
+	case '\r': e = 'r'; break;
+	case '\t': e = 't'; break;
+	default:
+		if(dst){
+			memcpy(dst, "\\u00", 4);
+			dst[4] = hex[c >> 4];
+			dst[5] = hex[c & 0x0F];
+		}
+		return(6);
+	}
+	if(dst){
+		dst[0] = '\\';
+		dst[1] = e;
+	}
+	return(2);
+}
+
+size_t json_escape(char *dst, const char *src, size_t len){
+/*
+    Escape len bytes of src for use inside a JSON string, without the
+    quotes and without a terminating NUL. With dst NULL nothing is written
+    and the exact output length is returned, so buffers can be sized with
+    a first call. Returns the number of bytes written.
+*/
+	const uint8_t *s;
+	uint8_t *d;
+	size_t i, n, out;
+	s = (const uint8_t *)src;
+	d = (uint8_t *)dst;
+	out = 0;
+	for(i = 0; i < len; i++){
+		n = JSON_escape_scan(&s[i], len - i);
+		if(d)memcpy(&d[out], &s[i], n);
+		out += n;
+		i += n;
+		if(i >= len)break;
+		out += JSON_escape_char(d ? &d[out] : NULL, s[i]);
+	}
+	return(out);
 }
 
 size_t strtojson(char *dst, const char *src, size_t siz){
-	size_t i, d;
+/*
+    strlcpy style: escape the NUL terminated src into dst of siz bytes and
+    terminate it. Output that does not fit is cut before the escape or
+    UTF-8 sequence that would overflow. Returns the length written.
+*/
+	const uint8_t *s;
+	size_t i, d, len, n;
 	if(siz < 1)return(0);
-	d = 0;
-	siz--;
-	for(i = 0; src[i]; i++){
-		if(src[i] == '\"'){
-			if((d + 2) >= siz)goto out;
-			dst[d++] = '\\';
-			dst[d++] = '\"';
-		}else if(src[i] == '\\'){
-			if((d + 2) >= siz)goto out;
-			dst[d++] = '\\';
-			dst[d++] = '\\';
-		}else if(src[i] == '\n'){
-			if((d + 2) >= siz)goto out;
-			dst[d++] = '\\';
-			dst[d++] = 'n';
-		}else if(src[i] == '\r'){
-			if((d + 2) >= siz)goto out;
-			dst[d++] = '\\';
-			dst[d++] = 'r';
-		}else if(src[i] == '\t'){
-			if((d + 2) >= siz)goto out;
-			dst[d++] = '\\';
-			dst[d++] = 't';
-		}else if(src[i] < 128){
-			if((d + 1) >= siz)goto out;
-			dst[d++] = src[i];
-		}else if(src[i] < 2048){
-			if((d + 2) >= siz)goto out;
-			dst[d++] = (src[i] >> 6) | 0xC0;
-			dst[d++] = (src[i] & 0x3F) | 0x80;
-		}else if(src[i] < 65536LU){
-			if((d + 3) >= siz)goto out;
-			dst[d++] = (src[i] >> 12) | 0xE0;
-			dst[d++] = ((src[i] >> 6) & 0x3F) | 0x80;
-			dst[d++] = (src[i] & 0x3F) | 0x80;
-		}else if(src[i] < 1114111LU){
-			if((d + 4) >= siz)goto out;
-			dst[d++] = (src[i] >> 18) | 0xF0;
-			dst[d++] = ((src[i] >> 12) & 0x3F) | 0x80;
-			dst[d++] = ((src[i] >> 6) & 0x3F) | 0x80;
-			dst[d++] = (src[i] & 0x3F) | 0x80;
-		}
-	}
-out:
+	len = strlen(src);
+	d = json_escape(NULL, src, len);
+	if(d >= siz){
+		s = (const uint8_t *)src;
+		for(i = 0, d = 0; i < len; i++){
+			n = (s[i] >= 0x20) && (s[i] != '\"') && (s[i] != '\\') ? 1 : JSON_escape_char(NULL, s[i]);
+			if((d + n) >= siz)break;
+			d += n;
+		}
+		while((i > 0) && (i < len) && ((s[i] & 0xC0) == 0x80))i--;
+		len = i;
+	}
+	d = json_escape(dst, src, len);
 	dst[d] = 0;
 	return(d);
 }
 
-
-
+/*
+    SIMD dispatch. Every pointer starts at its scalar version and is set
+    to the widest version the CPU supports once, when the library is
+    loaded and before any thread can call in, so a pointer is never
+    written while another thread reads it.
+*/
+__attribute__((constructor))
+static void JSON_dispatch_init(void){
+#ifdef JSON_SIMD_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")){
+		JSON_classify = JSON_classify_avx2;
+		JSON_newline_scan = JSON_newline_scan_avx2;
+		JSON_escape_scan = JSON_escape_scan_avx2;
+		JSON_copy_run = JSON_copy_run_avx2;
+	}else if(__builtin_cpu_supports("sse2")){
+		JSON_classify = JSON_classify_sse2;
+		JSON_newline_scan = JSON_newline_scan_sse2;
+		JSON_escape_scan = JSON_escape_scan_sse2;
+		JSON_copy_run = JSON_copy_run_sse2;
+	}
+#endif
+}
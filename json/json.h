@@ -1,7 +1,9 @@
 #ifndef _JSON_H_
 #define _JSON_H_
 
+#include <stddef.h>
 #include <stdint.h>
+#include <sys/types.h>
 
 #define JSON_TYPE_ERROR  0
 #define JSON_TYPE_NULL   1
@@ -19,20 +21,223 @@ typedef uint32_t json_utf8_t;
 typedef struct json_object{
 	int type;
 	uint8_t *start;
-	int len;
-	int count;
+	size_t len;
+	size_t count;
 }__attribute__((packed)) json_object_t;
 
-int json_check(uint8_t *ptr, int len, json_object_t *object);
-int json_get(uint8_t *ptr, int len, int index, json_object_t *key, json_object_t *value);
-int json_get_value(uint8_t *ptr, int len, char *key, json_object_t *value);
+typedef struct json_node{
+	int type;
+	size_t offset;
+	size_t len;
+	size_t count;
+	size_t next;
+}__attribute__((packed)) json_node_t;
+
+typedef struct json_tape{
+	uint8_t *ptr;
+	size_t len;
+	json_node_t *node;
+	size_t size;
+	size_t used;
+}json_tape_t;
+
+typedef struct json_arena{
+	uint8_t *buf;
+	size_t size;
+	size_t used;
+	void *blocks;
+}json_arena_t;
+
+typedef struct json_dom{
+	json_object_t value;
+	json_object_t key;
+	struct json_dom *child;
+	struct json_dom **index;
+}json_dom_t;
+
+typedef struct json_cursor{
+	int type;
+	uint8_t *ptr;
+	size_t len;
+	size_t pos;
+	int state;
+	int mode;
+	size_t index;
+}json_cursor_t;
+
+typedef struct json_keyset{
+	int n;
+	int bits;
+	int bucket_bits;
+	uint64_t seed;
+	uint32_t *disp;
+	int *table;
+	int *next;
+	size_t *len;
+	char **keys;
+}json_keyset_t;
+
+#define JSON_PHASE_CHECK  0	/* json_check */
+#define JSON_PHASE_LOOKUP 1	/* json_get and the batch lookups */
+#define JSON_PHASE_NUMBER 2	/* json_to_int, json_to_double */
+#define JSON_PHASE_STRING 3	/* json_string_decode, json_decode_string */
+#define JSON_PHASES       4
+
+typedef struct json_stats{
+	uint64_t bytes;		/* input bytes run through the state machine */
+	uint64_t rescans;	/* json_get calls, each one scans from the start */
+	uint64_t max_depth;
+	uint64_t number_decodes;
+	uint64_t string_decodes;
+	uint64_t calls[JSON_PHASES];
+	uint64_t cycles[JSON_PHASES];
+}json_stats_t;
+
+typedef struct json_file{
+	uint8_t *ptr;
+	size_t len;
+	int fd;
+}json_file_t;
+
+typedef struct json_stream json_stream_t;
+typedef struct json_query json_query_t;
+
+typedef struct json_ndjson{
+	int threads;
+	size_t batch;
+	size_t result_size;
+	int (*record)(void *ctx, json_object_t *record, void *result);
+	int (*emit)(void *ctx, json_object_t *record, void *result, int ok);
+	void *ctx;
+}json_ndjson_t;
+
+#define JSON_COLUMN_INT    1	/* int64_t */
+#define JSON_COLUMN_DOUBLE 2	/* double */
+#define JSON_COLUMN_STRING 3	/* json_object_t */
+#define JSON_COLUMN_BOOL   4	/* uint8_t */
+
+typedef struct json_column{
+	char *name;
+	int type;
+	void *data;
+	uint8_t *valid;
+}json_column_t;
+
+typedef struct json_columns{
+	json_column_t *column;
+	int n;
+	size_t capacity;
+	size_t rows;
+	json_keyset_t keys;
+}json_columns_t;
+
+#define JSON_WRITER_DEPTH 64
+
+typedef struct json_writer{
+	char *buf;
+	size_t size;
+	size_t len;
+	int fd;
+	int owned;
+	int error;
+	int top;
+	uint8_t stack[JSON_WRITER_DEPTH];
+}json_writer_t;
+
+typedef struct json_sax{
+	int (*start_object)(void *ctx);
+	int (*end_object)(void *ctx);
+	int (*start_array)(void *ctx);
+	int (*end_array)(void *ctx);
+	int (*key)(void *ctx, json_object_t *key);
+	int (*string)(void *ctx, json_object_t *value);
+	int (*integer)(void *ctx, json_object_t *value);
+	int (*real)(void *ctx, json_object_t *value);
+	int (*boolean)(void *ctx, int value);
+	int (*null)(void *ctx);
+}json_sax_t;
+
+int json_check(uint8_t *ptr, size_t len, json_object_t *object);
+int json_get(uint8_t *ptr, size_t len, size_t index, json_object_t *key, json_object_t *value);
+int json_get_value(uint8_t *ptr, size_t len, char *key, json_object_t *value);
+int json_get_values(uint8_t *ptr, size_t len, char **keys, int n, json_object_t *values);
+int json_keyset_init(json_keyset_t *ks, char **keys, int n);
+void json_keyset_free(json_keyset_t *ks);
+int json_keyset_lookup(json_keyset_t *ks, uint8_t *key, size_t len);
+int json_get_keyset(uint8_t *ptr, size_t len, json_keyset_t *ks, json_object_t *values);
+int json_get_pointer(uint8_t *ptr, size_t len, char *path, json_object_t *value);
+int json_trusted_check(uint8_t *ptr, size_t len, json_object_t *object);
+int json_trusted_get(uint8_t *ptr, size_t len, size_t index, json_object_t *key, json_object_t *value);
+int json_trusted_get_value(uint8_t *ptr, size_t len, char *key, json_object_t *value);
 int json_isequal(json_object_t *jstr, char *str);
-int json_value_isequal(uint8_t *ptr, int len, char *key, char *value);
+int json_value_isequal(uint8_t *ptr, size_t len, char *key, char *value);
+
+int json_stats_snapshot(json_stats_t *stats, int all);
+void json_stats_reset(int all);
+
+int json_file_open(json_file_t *file, const char *path);
+void json_file_close(json_file_t *file);
 
-int json_decode_string(const char *ptr, int len, json_utf8_t *utf8_char);
+int json_decode_string(const char *ptr, size_t len, json_utf8_t *utf8_char);
+ssize_t json_string_decode(json_object_t *ob, uint8_t *dst, size_t size);
+size_t json_escape(char *dst, const char *src, size_t len);
+size_t strtojson(char *dst, const char *src, size_t siz);
 
 long long int json_int(json_object_t *ob);
 double json_double(json_object_t *ob);
+int json_to_int(json_object_t *ob, long long int *value);
+int json_to_double(json_object_t *ob, double *value);
+int json_array_to_double(json_object_t *array, double *out, size_t size, size_t *count);
+int json_array_to_int(json_object_t *array, int64_t *out, size_t size, size_t *count);
+int json_itoa(long long int value, char *buf);
+int json_dtoa(double value, char *buf);
+
+size_t json_tape_parse(uint8_t *ptr, size_t len, json_tape_t *tape, json_node_t *node, size_t size);
+int json_tape_object(json_tape_t *tape, size_t node, json_object_t *object);
+size_t json_tape_get(json_tape_t *tape, size_t node, size_t index, json_object_t *key, json_object_t *value);
+size_t json_tape_get_value(json_tape_t *tape, size_t node, char *key, json_object_t *value);
+
+void json_arena_init(json_arena_t *arena, void *buf, size_t size);
+void *json_arena_alloc(json_arena_t *arena, size_t size);
+void json_arena_free(json_arena_t *arena);
+json_dom_t *json_dom_parse(uint8_t *ptr, size_t len, json_arena_t *arena);
+json_dom_t *json_dom_get(json_dom_t *dom, size_t index);
+json_dom_t *json_dom_get_value(json_dom_t *dom, char *key);
+
+int json_cursor_init(json_cursor_t *cur, json_object_t *container);
+int json_cursor_next(json_cursor_t *cur, json_object_t *key, json_object_t *value);
+
+int json_sax_parse(uint8_t *ptr, size_t len, json_sax_t *sax, void *ctx);
+
+json_stream_t *json_stream_init(size_t max, int (*value)(void *ctx, json_object_t *value), void *ctx);
+int json_stream_feed(json_stream_t *js, uint8_t *ptr, size_t len);
+int json_stream_finish(json_stream_t *js);
+
+int json_ndjson_parse(json_ndjson_t *nd, uint8_t *ptr, size_t len);
+int json_columns_init(json_columns_t *cols, json_column_t *column, int n, size_t capacity);
+void json_columns_free(json_columns_t *cols);
+int json_columns_array(json_columns_t *cols, uint8_t *ptr, size_t len);
+int json_columns_ndjson(json_columns_t *cols, uint8_t *ptr, size_t len, size_t *used);
+json_query_t *json_query_compile(const char *filter, char **fields, int n);
+void json_query_free(json_query_t *q);
+int json_query_record(json_query_t *q, uint8_t *ptr, size_t len, json_object_t *values);
+ssize_t json_query_ndjson(json_query_t *q, uint8_t *ptr, size_t len, json_writer_t *w);
+int json_check_parallel(uint8_t *ptr, size_t len, int threads, json_object_t *object);
+
+void json_writer_init(json_writer_t *w, char *buf, size_t size, int fd);
+int json_writer_flush(json_writer_t *w);
+void json_writer_free(json_writer_t *w);
+int json_write_begin_object(json_writer_t *w);
+int json_write_end_object(json_writer_t *w);
+int json_write_begin_array(json_writer_t *w);
+int json_write_end_array(json_writer_t *w);
+int json_write_key(json_writer_t *w, const char *key, size_t len);
+int json_write_string(json_writer_t *w, const char *str, size_t len);
+int json_write_int(json_writer_t *w, long long int value);
+int json_write_double(json_writer_t *w, double value);
+int json_write_bool(json_writer_t *w, int value);
+int json_write_null(json_writer_t *w);
+int json_write_value(json_writer_t *w, json_object_t *value);
 
 #ifdef MAIN_CONTROLLER
 #import <Foundation/Foundation.h>
@@ -45,7 +250,7 @@ double json_double(json_object_t *ob);
 @interface NSString (Json)
 -(id)jsonToData;
 @end
-id json_unserialize(const void *str, int len);
+id json_unserialize(const void *str, size_t len);
 #endif
 
 #endif
@@ -0,0 +1,414 @@
+/*
+    Consistency tests for the json module. Each fast path is run on
+    generated input next to the plain routine it stands in for, and any
+    difference is printed.
+
+    make test
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "json.h"
+
+#define DOC_LEN (4 << 20)
+
+static int failed;
+static uint32_t seed = 12345;
+
+static uint32_t rnd(void){
+	seed = seed * 1103515245 + 12345;
+	return(seed >> 8);
+}
+
+static void fail(const char *test, const char *what, size_t at){
+	if(failed++ < 20)printf("%s: %s at %zu\n", test, what, at);
+}
+
+static int same_object(json_object_t *a, json_object_t *b){
+	return((a->type == b->type) && (a->start == b->start) && (a->len == b->len) && (a->count == b->count));
+}
+
+/* one random value, strings carry the characters the scanners look for */
+static int gen_value(char *p, int depth){
+	int i, n, len;
+	len = 0;
+	switch(depth < 6 ? rnd() % 8 : rnd() % 5){
+	case 0:
+		len = sprintf(p, "%d", (int)(rnd() % 2000000) - 1000000);
+		break;
+	case 1:
+		len = sprintf(p, "%u.%ue%d", rnd() % 1000, rnd() % 1000, (int)(rnd() % 40) - 20);
+		break;
+	case 2:
+		n = rnd() % 40;
+		p[len++] = '\"';
+		for(i = 0; i < n; i++){
+			if(rnd() % 8 == 0){
+				len += sprintf(p + len, "%s", (rnd() & 1) ? "\\\"" : "\\\\");
+			}else{
+				p[len++] = "abc xyz{}[],:-"[rnd() % 14];
+			}
+		}
+		p[len++] = '\"';
+		break;
+	case 3:
+		len = sprintf(p, "%s", (rnd() & 1) ? "true" : "false");
+		break;
+	case 4:
+		len = sprintf(p, "null");
+		break;
+	case 5:
+	case 6:
+		n = rnd() % 5;
+		p[len++] = '{';
+		for(i = 0; i < n; i++){
+			len += sprintf(p + len, "%s\"k%u\": ", i ? ", " : "", rnd() % 16);
+			len += gen_value(p + len, depth + 1);
+		}
+		p[len++] = '}';
+		break;
+	default:
+		n = rnd() % 5;
+		p[len++] = '[';
+		for(i = 0; i < n; i++){
+			if(i)p[len++] = ',';
+			len += gen_value(p + len, depth + 1);
+		}
+		p[len++] = ']';
+		break;
+	}
+	return(len);
+}
+
+/* a top level array of random values, about DOC_LEN bytes long */
+static size_t gen_doc(char *doc){
+	size_t len;
+	len = 0;
+	doc[len++] = '[';
+	while(len < DOC_LEN - 65536){
+		if(len > 1)len += sprintf(doc + len, "%s", (rnd() % 4) ? "," : ",\n  ");
+		len += gen_value(doc + len, 0);
+	}
+	doc[len++] = ']';
+	return(len);
+}
+
+/*
+    json_check_parallel against json_check, on the document as generated
+    and with single bytes replaced, half of them next to a chunk boundary
+    where the speculative runs have to guess the state they start in.
+*/
+static void test_parallel(char *doc, size_t len){
+	static const int threads[] = {2, 3, 4, 7};
+	json_object_t a, b;
+	size_t at;
+	int i, t, ra, rb;
+	char c;
+	for(i = 0; i < 64; i++){
+		t = threads[i % 4];
+		at = (i & 1) ? (len / t) * (1 + rnd() % (t - 1)) + rnd() % 64 - 32 : rnd() % len;
+		c = doc[at];
+		if(i > 0)doc[at] = "\"\\{}[],: x1"[rnd() % 11];
+		memset(&a, 0, sizeof(a));
+		memset(&b, 0, sizeof(b));
+		ra = json_check((uint8_t *)doc, len, &a);
+		rb = json_check_parallel((uint8_t *)doc, len, t, &b);
+		if((ra != rb) || (ra && !same_object(&a, &b)))fail("json_check_parallel", "differs from json_check", at);
+		doc[at] = c;
+	}
+}
+
+/*
+    json_to_double against strtod, bit for bit: numbers with up to 25
+    digits across the whole exponent range, shortest round trip forms of
+    random doubles including subnormals, and texts next to the midpoint of
+    two neighbouring doubles, where the Eisel-Lemire path must give up
+    rather than round the wrong way. Out of range texts must be rejected.
+*/
+static void test_to_double(void){
+	json_object_t ob;
+	char text[128];
+	uint64_t bits;
+	double d, e, ref;
+	int i, j, n, ok;
+	ob.type = JSON_TYPE_DOUBLE;
+	ob.start = (uint8_t *)text;
+	for(i = 0; i < 300000; i++){
+		n = 0;
+		switch(i % 3){
+		case 0:
+			if(rnd() & 1)text[n++] = '-';
+			text[n++] = '1' + rnd() % 9;
+			for(j = rnd() % 20; j > 0; j--)text[n++] = '0' + rnd() % 10;
+			if(rnd() & 1){
+				text[n++] = '.';
+				for(j = 1 + rnd() % 5; j > 0; j--)text[n++] = '0' + rnd() % 10;
+			}
+			n += sprintf(text + n, "e%d", (int)(rnd() % 680) - 350);
+			break;
+		case 1:
+			bits = ((uint64_t)rnd() << 40) ^ ((uint64_t)rnd() << 16) ^ rnd();
+			memcpy(&d, &bits, sizeof(d));
+			if(!isfinite(d))d = 1.0;
+			n = sprintf(text, "%.17g", d);
+			break;
+		default:
+			d = ldexp((double)(rnd() | 1), (int)(rnd() % 2000) - 1000);
+			e = nextafter(d, INFINITY);
+			n = sprintf(text, "%.*Le", (int)(17 + rnd() % 8), (long double)d + ((long double)e - d) / 2);
+			break;
+		}
+		text[n] = 0;
+		ob.len = n;
+		ref = strtod(text, NULL);
+		ok = json_to_double(&ob, &d);
+		if(!isfinite(ref) ? ok : (!ok || memcmp(&d, &ref, sizeof(d))))fail("json_to_double", text, i);
+	}
+}
+
+/*
+    json_get_keyset against json_get_values and json_get_value on small
+    objects whose keys come from a set of short and long names, with
+    repeated and absent keys in the set. A large set must hold and find
+    every one of its keys.
+*/
+static void test_keyset(void){
+	json_object_t values[8], plain[8], one;
+	json_keyset_t ks;
+	char name[32][32], *keys[8], doc[8192], *big[5000];
+	int i, j, k, n, len, ra, rb;
+	for(i = 0; i < 32; i++)sprintf(name[i], (i & 1) ? "k%d" : "member_with_a_long_name_%d", i);
+	for(i = 0; i < 20000; i++){
+		n = 1 + rnd() % 8;
+		for(j = 0; j < n; j++)keys[j] = name[rnd() % 32];
+		if(!json_keyset_init(&ks, keys, n)){
+			fail("json_keyset_init", "rejected", i);
+			continue;
+		}
+		len = sprintf(doc, "{");
+		for(j = rnd() % 12; j > 0; j--){
+			len += sprintf(doc + len, "\"%s\":", name[rnd() % 24]);
+			len += gen_value(doc + len, 5);
+			doc[len++] = ',';
+		}
+		if(len > 1)len--;
+		doc[len++] = '}';
+		ra = json_get_keyset((uint8_t *)doc, len, &ks, values);
+		rb = json_get_values((uint8_t *)doc, len, keys, n, plain);
+		if(ra != rb)fail("json_get_keyset", "count differs from json_get_values", i);
+		for(j = 0; j < n; j++){
+			if(!same_object(&values[j], &plain[j]))fail("json_get_keyset", "value differs from json_get_values", i);
+			k = json_get_value((uint8_t *)doc, len, keys[j], &one);
+			if(k ? !same_object(&values[j], &one) : (values[j].type != JSON_TYPE_ERROR))fail("json_get_keyset", "value differs from json_get_value", i);
+		}
+		json_keyset_free(&ks);
+	}
+	for(i = 0; i < 5000; i++){
+		big[i] = malloc(32);
+		sprintf(big[i], (i % 3) ? "field.%d" : "a_much_longer_field_name.%d", i / 2);
+	}
+	if(!json_keyset_init(&ks, big, 5000)){
+		fail("json_keyset_init", "rejected 5000 keys", 0);
+	}else{
+		for(i = 0; i < 5000; i++){
+			j = json_keyset_lookup(&ks, (uint8_t *)big[i], strlen(big[i]));
+			if((j < 0) || strcmp(ks.keys[j], big[i]))fail("json_keyset_lookup", big[i], i);
+		}
+		if(json_keyset_lookup(&ks, (uint8_t *)"field.5000", 10) >= 0)fail("json_keyset_lookup", "found field.5000", 0);
+		json_keyset_free(&ks);
+	}
+	for(i = 0; i < 5000; i++)free(big[i]);
+}
+
+/*
+    Queries and NDJSON ingestion against json_check and json_get_pointer
+    run line by line: every filter below comes with the same predicate
+    written with the plain lookups, over log records with missing members,
+    blank lines and broken lines.
+*/
+
+#define RECORDS_LEN (1 << 20)
+
+static int plain_string(uint8_t *p, size_t l, char *path, char *s){
+	json_object_t v;
+	return(json_get_pointer(p, l, path, &v) && json_isequal(&v, s));
+}
+
+static int plain_number(uint8_t *p, size_t l, char *path, double *d){
+	json_object_t v;
+	return(json_get_pointer(p, l, path, &v) && ((v.type == JSON_TYPE_INT) || (v.type == JSON_TYPE_DOUBLE)) && json_to_double(&v, d));
+}
+
+static int plain_match(int filter, uint8_t *p, size_t l){
+	json_object_t v;
+	double d;
+	switch(filter){
+	case 0:
+		return(1);
+	case 1:
+		return(plain_string(p, l, "/level", "error"));
+	case 2:
+		return(plain_number(p, l, "/latency", &d) && (d > 500));
+	case 3:
+		return(plain_string(p, l, "/level", "error") && json_get_pointer(p, l, "/ok", &v) && (v.type == JSON_TYPE_TRUE));
+	case 4:
+		return(plain_number(p, l, "/user/id", &d) && (d <= 100));
+	case 5:
+		return(plain_string(p, l, "/tags/1", "db"));
+	case 6:
+		return(json_get_pointer(p, l, "/user/name", &v));
+	default:
+		return(json_get_pointer(p, l, "/level", &v) && !json_isequal(&v, "info"));
+	}
+}
+
+static size_t gen_records(char *buf){
+	static char *level[] = {"info", "error", "warn"};
+	static char *tag[] = {"db", "api", "cache"};
+	size_t len, start;
+	len = 0;
+	while(len < RECORDS_LEN - 512){
+		start = len;
+		if(rnd() % 16 == 0)buf[len++] = ' ';
+		len += sprintf(buf + len, "{\"ts\":%u", rnd());
+		if(rnd() % 8)len += sprintf(buf + len, ",\"level\":\"%s\"", level[rnd() % 3]);
+		if(rnd() % 8)len += sprintf(buf + len, ",\"latency\":%u.%u", rnd() % 1000, rnd() % 10);
+		if(rnd() % 8)len += sprintf(buf + len, ",\"ok\":%s", (rnd() % 3) ? ((rnd() & 1) ? "true" : "false") : "null");
+		if(rnd() % 8)len += sprintf(buf + len, ",\"user\":{\"id\":%u%s}", rnd() % 400, (rnd() % 4) ? ",\"name\":\"someone\"" : "");
+		if(rnd() % 8)len += sprintf(buf + len, ",\"tags\":[\"%s\",\"%s\"]", tag[rnd() % 3], tag[rnd() % 3]);
+		buf[len++] = '}';
+		if(rnd() % 32 == 0)buf[start + rnd() % (len - start)] = "{}[\",:"[rnd() % 6];
+		if(rnd() % 16 == 0)buf[len++] = '\n';
+		buf[len++] = '\n';
+	}
+	return(len);
+}
+
+struct test_ndjson{
+	uint8_t *ptr;
+	size_t len;
+	size_t pos;
+};
+
+/* next non blank line, trimmed of spaces */
+static int next_line(uint8_t *ptr, size_t len, size_t *pos, uint8_t **line, size_t *l){
+	uint8_t *nl;
+	while(*pos < len){
+		nl = memchr(&ptr[*pos], '\n', len - *pos);
+		*line = &ptr[*pos];
+		*l = (nl != NULL) ? (size_t)(nl - *line) : len - *pos;
+		*pos += *l + 1;
+		while(*l && (**line == ' ')){
+			(*line)++;
+			(*l)--;
+		}
+		while(*l && ((*line)[*l - 1] == ' '))(*l)--;
+		if(*l)return(1);
+	}
+	return(0);
+}
+
+static int ndjson_record(void *ctx, json_object_t *record, void *result){
+	(void)ctx;
+	return(json_get_value(record->start, record->len, "ts", (json_object_t *)result));
+}
+
+static int ndjson_emit(void *ctx, json_object_t *record, void *result, int ok){
+	struct test_ndjson *t;
+	json_object_t ob, ts;
+	uint8_t *line;
+	size_t l;
+	t = (struct test_ndjson *)ctx;
+	if(!next_line(t->ptr, t->len, &t->pos, &line, &l) || (record->start != line) || (record->len != l)){
+		fail("json_ndjson_parse", "emitted a line out of order", t->pos);
+	}else if(ok != (json_check(line, l, &ob) && json_get_value(line, l, "ts", &ts))){
+		fail("json_ndjson_parse", "ok differs from json_check", t->pos);
+	}else if(ok && !same_object((json_object_t *)result, &ts)){
+		fail("json_ndjson_parse", "record result differs from json_get_value", t->pos);
+	}
+	return(1);
+}
+
+static void test_query(void){
+	static char *filter[] = {
+		"",
+		"@.level == \"error\"",
+		"@.latency > 500",
+		"@.level == 'error' && @.ok == true",
+		"$.user.id <= 100",
+		"@.tags[1] == \"db\"",
+		"@['user'].name",
+		"@.level != \"info\""
+	};
+	static char *fields[] = {"@.ts", "@.user.name"};
+	static char *pointer[] = {"/ts", "/user/name"};
+	struct test_ndjson t;
+	json_object_t values[2], ob, v;
+	json_ndjson_t nd;
+	json_writer_t w;
+	json_query_t *q;
+	uint8_t *ptr, *line;
+	size_t len, pos, l;
+	ssize_t count, matches;
+	int f, i, ra, rb;
+	ptr = malloc(RECORDS_LEN);
+	if(ptr == NULL){
+		fail("json_query_ndjson", "no memory", 0);
+		return;
+	}
+	len = gen_records((char *)ptr);
+	for(f = 0; f < (int)(sizeof(filter) / sizeof(filter[0])); f++){
+		q = json_query_compile(filter[f], fields, 2);
+		if(q == NULL){
+			fail("json_query_compile", filter[f], f);
+			continue;
+		}
+		matches = 0;
+		for(pos = 0; next_line(ptr, len, &pos, &line, &l);){
+			ra = json_query_record(q, line, l, values);
+			rb = json_check(line, l, &ob) && plain_match(f, line, l);
+			matches += rb;
+			if(ra != rb)fail(filter[f], "json_query_record differs from the plain lookups", pos);
+			for(i = 0; ra && rb && (i < 2); i++){
+				if(json_get_pointer(line, l, pointer[i], &v) ? !same_object(&values[i], &v) : (values[i].type != JSON_TYPE_ERROR)){
+					fail(fields[i], "json_query_record value differs from json_get_pointer", pos);
+				}
+			}
+		}
+		json_writer_init(&w, NULL, 0, -1);
+		count = json_query_ndjson(q, ptr, len, &w);
+		if(count != matches)fail(filter[f], "json_query_ndjson count differs from the plain lookups", count);
+		json_writer_free(&w);
+		json_query_free(q);
+	}
+	memset(&nd, 0, sizeof(nd));
+	nd.threads = 3;
+	nd.batch = 4096;
+	nd.result_size = sizeof(json_object_t);
+	nd.record = ndjson_record;
+	nd.emit = ndjson_emit;
+	nd.ctx = &t;
+	t.ptr = ptr;
+	t.len = len;
+	t.pos = 0;
+	if(!json_ndjson_parse(&nd, ptr, len))fail("json_ndjson_parse", "failed", 0);
+	if(next_line(ptr, len, &t.pos, &line, &l))fail("json_ndjson_parse", "stopped early", t.pos);
+	free(ptr);
+}
+
+int main(void){
+	char *doc;
+	size_t len;
+	doc = malloc(DOC_LEN);
+	if(doc == NULL)return(1);
+	len = gen_doc(doc);
+	test_parallel(doc, len);
+	test_to_double();
+	test_keyset();
+	test_query();
+	free(doc);
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return(failed ? 1 : 0);
+}